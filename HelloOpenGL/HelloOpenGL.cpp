@@ -1,4 +1,11 @@
+﻿#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
@@ -10,17 +17,51 @@
 #include <stb/stb_image.h>
 
 #include "LearnOpenGL/Graphics/Camera.h"
+#include "LearnOpenGL/Graphics/DeferredRenderer.h"
+#include "LearnOpenGL/Graphics/DynamicRingBuffer.h"
+#include "LearnOpenGL/Graphics/Framebuffer.h"
+#include "LearnOpenGL/Graphics/GLExtensions.h"
+#include "LearnOpenGL/Graphics/GLStateCache.h"
+#include "LearnOpenGL/Graphics/LightClusters.h"
+#include "LearnOpenGL/Graphics/RenderQueue.h"
 #include "LearnOpenGL/Graphics/Shader.h"
+#include "LearnOpenGL/Graphics/ShaderCache.h"
+#include "LearnOpenGL/Graphics/ShaderCompileBatch.h"
+#include "LearnOpenGL/Graphics/ShaderVariants.h"
 #include "LearnOpenGL/Graphics/Texture2D.h"
+#include "LearnOpenGL/Graphics/TextureRegistry.h"
+#include "LearnOpenGL/Graphics/UniformBlocks.h"
+#include "LearnOpenGL/Graphics/UniformBuffer.h"
+#include "LearnOpenGL/Graphics/UploadScheduler.h"
+#include "LearnOpenGL/Math/Frustum.h"
 #include "LearnOpenGL/Math/Transform.h"
 #include "LearnOpenGL/Math/Vector3.h"
+#include "LearnOpenGL/Model/GeometryArena.h"
 #include "LearnOpenGL/Model/Model.h"
 #include "LearnOpenGL/Utilities/Timer.h"
 
 typedef LearnOpenGL::Graphics::Shader Shader;
+typedef LearnOpenGL::Graphics::ShaderCache ShaderCache;
+typedef LearnOpenGL::Graphics::ShaderCompileBatch ShaderCompileBatch;
+typedef LearnOpenGL::Graphics::ShaderPermutation ShaderPermutation;
+typedef LearnOpenGL::Graphics::ShaderVariants ShaderVariants;
+typedef LearnOpenGL::Graphics::UniformHandle UniformHandle;
+typedef LearnOpenGL::Graphics::UniformBuffer UniformBuffer;
+typedef LearnOpenGL::Graphics::FrameUniforms FrameUniforms;
+typedef LearnOpenGL::Graphics::LightUniforms LightUniforms;
+typedef LearnOpenGL::Graphics::PointLightData PointLightData;
+typedef LearnOpenGL::Graphics::LightClusters LightClusters;
 typedef LearnOpenGL::Graphics::Texture2D Texture2D;
 typedef LearnOpenGL::Math::Transform Transform;
+typedef LearnOpenGL::Math::Frustum Frustum;
 typedef LearnOpenGL::Graphics::Camera Camera;
+typedef LearnOpenGL::Graphics::GLStateCache GLStateCache;
+typedef LearnOpenGL::Graphics::GLExtensions GLExtensions;
+typedef LearnOpenGL::Graphics::RenderQueue RenderQueue;
+typedef LearnOpenGL::Graphics::DynamicRingBuffer DynamicRingBuffer;
+typedef LearnOpenGL::Graphics::Framebuffer Framebuffer;
+typedef LearnOpenGL::Graphics::DeferredRenderer DeferredRenderer;
+typedef LearnOpenGL::Graphics::UploadScheduler UploadScheduler;
 typedef LearnOpenGL::Utilities::Timer Timer;
 typedef LearnOpenGL::Model::Model Model;
 
@@ -50,6 +91,14 @@ float spotLightAngle = 0.0f;
 float spotLightBrightness = 0.75f;
 
 float environmentBrightness = 0.5f;
+int instancedModelCount = 0;
+bool enableFrustumCulling = true;
+bool enableMultiDraw = true;
+bool enableClusteredLighting = true;
+bool enableDeferredShading = false;
+int extraPointLightCount = 0;
+float modelLoadBudgetMilliseconds = 4.0f;
+int uploadBudgetMebibytes = 8;
 bool fFirstPressed = false;
 
 void render(Shader& shader, unsigned int planeVao, Texture2D& floorTexture, Model& testModel, Model& testModel2);
@@ -96,12 +145,14 @@ int main()
     }
     std::cerr << "glad to be here\n";
 
+    GLExtensions::load(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
     glfwSetFramebufferSizeCallback(window, &frameBufferSizeCallback);
     glfwSetCursorPosCallback(window, mouseCallback);
     glfwSetScrollCallback(window, scrollCallback);
     glfwSwapInterval(1);
 
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     // imgui setup
 
@@ -124,278 +175,581 @@ int main()
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init();
 
-    // rendering setup
-    std::cerr << "shader\n";
-
-    Shader shader{ "vertex.glsl", "phong.frag" };
-
-    std::cerr << "model\n";
-    stbi_set_flip_vertically_on_load(true);
-
-    Model::debugLogging = true;
-
-    Model testModel{ "Res/backpack/backpack.obj" };
-    Model testModel2{ "Res/textured_car/untitled.obj" };
-
-    float vertices[] = {
-        10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 0.0f,
-        -10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-        -10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f,
-
-        10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 0.0f,
-        -10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f,
-        10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 10.0f
-    };
-
-    unsigned int indices[] = {
-        0, 1, 2,
-        3, 4, 5
-    };
-
-    // plane VAO
-    unsigned int planeVao, planeVbo, planeEbo;
-    glGenVertexArrays(1, &planeVao);
-    glGenBuffers(1, &planeVbo);
-    glGenBuffers(1, &planeEbo);
-    glBindVertexArray(planeVao);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEbo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<const void*>(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<const void*>(6 * sizeof(float)));
-    glBindVertexArray(0);
-
-    // FBO
-    unsigned int fbo;
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-    unsigned int fboTexture;
-    glGenTextures(1, &fboTexture);
-    glBindTexture(GL_TEXTURE_2D, fboTexture);
-
-    int ww;
-    int wh;
-    glfwGetWindowSize(window, &ww, &wh);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ww, wh, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexture, 0);
-
-    unsigned int framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    // generate texture
-    unsigned int textureColorBuffer;
-    glGenTextures(1, &textureColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ww, wh, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorBuffer, 0);
-
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, ww, wh);
-
-    // use a single renderbuffer object for both a depth AND stencil buffer.
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo); // now actually attach it
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    // everything holding GL objects lives in here, so it is released while the context is still current
     {
-        // execute non-victory dance
-        std::cerr << "Victory was not achieved.\n";
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    }
-
-    Texture2D floorTexture{ "Res/wood.png", true, true };
-    floorTexture.setTextureWrap(GL_REPEAT, GL_REPEAT);
-    floorTexture.setTextureFilters(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
-
-    // game loop except not in the slightest
-    ImVec4 clearColor{ 0.1f, 0.1f, 0.1f, 1.0f };
+        // rendering setup
+        std::cerr << "shader\n";
+
+        // the programs build on the driver's compiler threads while the models start importing
+        ShaderCompileBatch shaderBatch;
+        const size_t shaderIndex = shaderBatch.add("vertex.glsl", "phong.frag");
+        // draws many copies of a model in one call per mesh, with the model matrices streamed as vertex attributes
+        const size_t instancedShaderIndex = shaderBatch.add("vertex_instanced.glsl", "phong.frag");
+        // the same two, writing the G-buffer for deferred shading instead of lighting
+        const size_t gBufferShaderIndex = shaderBatch.add("vertex.glsl", "gbuffer.frag");
+        const size_t instancedGBufferShaderIndex = shaderBatch.add("vertex_instanced.glsl", "gbuffer.frag");
+        shaderBatch.submit();
+
+        std::cerr << "model\n";
+        stbi_set_flip_vertically_on_load(true);
+
+        Model::debugLogging = true;
+
+        // both stream in while the scene keeps rendering; they draw nothing until loaded
+        const std::unique_ptr<Model> testModel = Model::loadAsync("Res/backpack/backpack.obj");
+        const std::unique_ptr<Model> testModel2 = Model::loadAsync("Res/textured_car/untitled.obj");
+
+        // nothing can be drawn before the programs are done, so spend the wait on the models
+        while (!shaderBatch.isComplete())
+        {
+            Model::updateAsyncLoads(std::chrono::microseconds(static_cast<long long>(modelLoadBudgetMilliseconds * 1000.0f)));
+            std::this_thread::yield();
+        }
 
-    ImVec2 sceneWindowSize{ 1280.0f, 720.0f };
+        std::vector<Shader> shaders = shaderBatch.finish();
+        Shader& shader = shaders[shaderIndex];
+        Shader& gBufferShader = shaders[gBufferShaderIndex];
 
-    while (!glfwWindowShouldClose(window))
-    {
-        timer.evaluateDeltaTime();
+        // the plane is drawn with either program depending on the shading mode
+        struct PlaneProgram
+        {
+            const Shader* shader;
+            UniformHandle model;
+            UniformHandle normalMatrix;
+            UniformHandle compactVertices;
+            UniformHandle useTextureArrays;
+            UniformHandle shininess;
+        };
+
+        // resolve per-frame uniforms once, instead of building and looking up their names every frame
+        const auto resolvePlaneProgram = [](const Shader& program)
+        {
+            return PlaneProgram{ &program, program.getUniform("model"), program.getUniform("normalMatrix"),
+                                 program.getUniform("compactVertices"), program.getUniform("useTextureArrays"),
+                                 program.getUniform("material.shininess") };
+        };
 
-        glfwPollEvents();
+        const PlaneProgram forwardPlaneProgram = resolvePlaneProgram(shader);
+        const PlaneProgram gBufferPlaneProgram = resolvePlaneProgram(gBufferShader);
 
-        processInput(window);
+        Model::setupSamplerUnits(shader);
+        LightClusters::setupSamplerUnits(shader);
+        Model::setupSamplerUnits(gBufferShader);
 
-        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
+        Shader& instancedShader = shaders[instancedShaderIndex];
+        const UniformHandle instancedShininessUniform = instancedShader.getUniform("material.shininess");
+        Model::setupSamplerUnits(instancedShader);
+        LightClusters::setupSamplerUnits(instancedShader);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        Shader& instancedGBufferShader = shaders[instancedGBufferShaderIndex];
+        const UniformHandle instancedGBufferShininessUniform = instancedGBufferShader.getUniform("material.shininess");
+        Model::setupSamplerUnits(instancedGBufferShader);
+        std::vector<glm::mat4> instanceTransforms;
 
-        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
+        const auto setupModelShader = [](const Shader& variant)
+        {
+            Model::setupSamplerUnits(variant);
+            LightClusters::setupSamplerUnits(variant);
+            variant.setFloat("material.shininess", 32.0f);
+        };
+
+        // models draw with programs specialized for each material and the lights in use, instead of the ones above
+        ShaderVariants modelShaders{ "vertex.glsl", "phong.frag", setupModelShader };
+        // the G-buffer programs only vary by material, so they are looked up with a permutation without scene features
+        ShaderVariants gBufferModelShaders{ "vertex.glsl", "gbuffer.frag", setupModelShader };
+        const ShaderPermutation gBufferPermutation{};
+        // the lighting pass only varies by the lights in use
+        ShaderVariants deferredLightingShaders{ "deferred_lighting.vert", "deferred_lighting.frag", [](const Shader& variant)
+        {
+            DeferredRenderer::setupSamplerUnits(variant);
+            LightClusters::setupSamplerUnits(variant);
+        } };
 
-        // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            using namespace LearnOpenGL::Graphics;
 
-        int windowWidth;
-        int windowHeight;
-        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            // every scene permutation the inspector can switch to, so toggling a setting never compiles mid-frame
+            const ShaderPermutation scenePermutations[] = { { ShaderFeatureClusteredLights, 0 },
+                                                            { ShaderFeatureClusteredLights | ShaderFeatureSpotLight, 0 },
+                                                            { 0, MaxPointLights },
+                                                            { ShaderFeatureSpotLight, MaxPointLights } };
+            const uint32_t materialFeatureSets[] = { 0u, ShaderFeatureTextures2D, ShaderFeatureTextureArrays,
+                                                     ShaderFeatureDrawTable | ShaderFeatureTextures2D | ShaderFeatureTextureArrays };
 
-        glViewport(0, 0, sceneWindowSize.x, sceneWindowSize.y);
+            std::vector<ShaderPermutation> permutations;
+            std::vector<ShaderPermutation> gBufferPermutations;
 
-        const glm::mat4 view = camera.calculateView();
-        const glm::mat4 projection = camera.calculateProjection();
+            for (const uint32_t materialFeatures : materialFeatureSets)
+            {
+                for (const ShaderPermutation& scenePermutation : scenePermutations)
+                {
+                    permutations.push_back({ scenePermutation.features | materialFeatures, scenePermutation.pointLights });
+                }
 
-        auto diffuseColor = glm::vec3(0.5f * environmentBrightness);
-        auto ambientColor = glm::vec3(0.1f * environmentBrightness);
-        auto specularColor = glm::vec3(0.5f * environmentBrightness);
-        auto spotLightDiffuseColor = glm::vec3(1.25f, 1.0f, 1.0f) * spotLightBrightness;
-        auto spotLightAmbientColor = glm::vec3(0.0f) * spotLightBrightness;
-        auto spotLightSpecularColor = glm::vec3(1.0f) * spotLightBrightness;
-        const float cutoff = glm::cos(glm::radians(12.5f));
-        const float outerCutoff = glm::cos(glm::radians(17.5f));
+                gBufferPermutations.push_back({ gBufferPermutation.features | materialFeatures, gBufferPermutation.pointLights });
+            }
 
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setFloat("material.shininess", 32.0f);
-        shader.setVec3("viewPosition", camera.cameraPos);
+            modelShaders.prepare(permutations);
+            gBufferModelShaders.prepare(gBufferPermutations);
+            deferredLightingShaders.prepare(scenePermutations);
+        }
 
-        for (int i = 0; i < 4; i++)
+        // camera and light data is shared by every program through uniform blocks, uploaded once per frame
+        UniformBuffer frameUniformBuffer{ LearnOpenGL::Graphics::FrameUniformsBlockName, sizeof(FrameUniforms), true };
+        UniformBuffer lightUniformBuffer{ LearnOpenGL::Graphics::LightUniformsBlockName, sizeof(LightUniforms), true };
+
+        FrameUniforms frameUniforms{};
+        LightUniforms lightUniforms{};
+
+        // every point light goes through the clusters; without them, programs only see the first MaxPointLights
+        LightClusters lightClusters;
+        std::vector<PointLightData> pointLights;
+        // extra lights wander around their anchors, so the clusters are rebuilt from moving lights every frame
+        std::vector<PointLightData> extraLightAnchors;
+        std::mt19937 extraLightRandom{ 1234 };
+
+        float vertices[] = {
+            10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 0.0f,
+            -10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+            -10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f,
+
+            10.0f, -0.5f, 10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 0.0f,
+            -10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f,
+            10.0f, -0.5f, -10.0f, 0.0f, 1.0f, 0.0f, 10.0f, 10.0f
+        };
+
+        unsigned int indices[] = {
+            0, 1, 2,
+            3, 4, 5
+        };
+
+        // plane VAO
+        unsigned int planeVao, planeVbo, planeEbo;
+        glGenVertexArrays(1, &planeVao);
+        glGenBuffers(1, &planeVbo);
+        glGenBuffers(1, &planeEbo);
+        GLStateCache::bindVertexArray(planeVao);
+        glBindBuffer(GL_ARRAY_BUFFER, planeVbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEbo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<const void*>(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<const void*>(6 * sizeof(float)));
+        GLStateCache::bindVertexArray(0);
+
+        int ww;
+        int wh;
+        glfwGetWindowSize(window, &ww, &wh);
+
+        // the scene is rendered into a texture, shown in the scene view
+        Framebuffer sceneFramebuffer{ ww, wh, { { GL_RGB, GL_RGB, GL_UNSIGNED_BYTE } } };
+
+        if (!sceneFramebuffer.isComplete())
         {
-            shader.setVec3("pointLights[" + std::to_string(i) + "].position", pointLightPositions[i]);
-            shader.setVec3("pointLights[" + std::to_string(i) + "].ambient", ambientColor);
-            shader.setVec3("pointLights[" + std::to_string(i) + "].diffuse", diffuseColor);
-            shader.setVec3("pointLights[" + std::to_string(i) + "].specular", specularColor);
+            // execute non-victory dance
+            std::cerr << "Victory was not achieved.\n";
+            GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
         }
 
-        shader.setVec3("directionalLight.direction", Vector3::Down + Vector3::Forward);
-        shader.setVec3("directionalLight.ambient", ambientColor);
-        shader.setVec3("directionalLight.diffuse", diffuseColor);
-        shader.setVec3("directionalLight.specular", specularColor);
-        shader.setVec3("spotLight.position", spotLightPosition);
-        shader.setVec3("spotLight.direction", spotLightDirection + (Vector3::Forward * spotLightAngle));
-        shader.setFloat("spotLight.cutoff", cutoff);
-        shader.setFloat("spotLight.outerCutoff", outerCutoff);
+        // G-buffer and lighting pass, used instead of lighting every fragment while deferred shading is on
+        DeferredRenderer deferredRenderer{ ww, wh };
 
-        if (enableSpotLight)
-        {
-            shader.setVec3("spotLight.ambient", spotLightAmbientColor);
-            shader.setVec3("spotLight.diffuse", spotLightDiffuseColor);
-            shader.setVec3("spotLight.specular", spotLightSpecularColor);
-        }
-        else
+        Texture2D floorTexture{ "Res/wood.png", true, true };
+        floorTexture.setTextureWrap(GL_REPEAT, GL_REPEAT);
+        floorTexture.setTextureFilters(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+
+        // game loop except not in the slightest
+        ImVec4 clearColor{ 0.1f, 0.1f, 0.1f, 1.0f };
+
+        ImVec2 sceneWindowSize{ 1280.0f, 720.0f };
+
+        RenderQueue renderQueue;
+
+        while (!glfwWindowShouldClose(window))
         {
-            shader.setVec3("spotLight.ambient", Vector3::Zero);
-            shader.setVec3("spotLight.diffuse", Vector3::Zero);
-            shader.setVec3("spotLight.specular", Vector3::Zero);
-        }
+            timer.evaluateDeltaTime();
+            GLStateCache::beginFrame();
 
-        glBindVertexArray(planeVao);
-        shader.use();
-        floorTexture.use(GL_TEXTURE0);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+            Model::updateAsyncLoads(std::chrono::microseconds(static_cast<long long>(modelLoadBudgetMilliseconds * 1000.0f)));
+            UploadScheduler::getShared().update();
 
-        Transform modelTransform{};
-        shader.setMat4("model", modelTransform.get());
-        testModel.draw(shader);
+            glfwPollEvents();
 
-        modelTransform.translate(Vector3::Forward * 5.0f);
-        shader.setMat4("model", modelTransform.get());
-        testModel2.draw(shader);
-        glBindVertexArray(0);
+            processInput(window);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            GLStateCache::enable(GL_DEPTH_TEST);
 
-        ImGui::SetNextWindowPos(ImVec2{ 0.0f, 0.0f }, ImGuiCond_Once);
-        ImGui::SetNextWindowSize(ImVec2{ static_cast<float>(windowWidth), static_cast<float>(windowHeight) }, ImGuiCond_Once);
-        ImGui::Begin("how does this even begin to qualify as a game engine");
-        {
-            ImGui::BeginChild("Engine Content");
+            sceneFramebuffer.bind();
+
+            glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Start the Dear ImGui frame
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            int windowWidth;
+            int windowHeight;
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+            glViewport(0, 0, sceneWindowSize.x, sceneWindowSize.y);
+            camera.setViewport(static_cast<int>(sceneWindowSize.x), static_cast<int>(sceneWindowSize.y));
+
+            const glm::mat4 view = camera.calculateView();
+            const glm::mat4 projection = camera.calculateProjection();
+
+            auto diffuseColor = glm::vec3(0.5f * environmentBrightness);
+            auto ambientColor = glm::vec3(0.1f * environmentBrightness);
+            auto specularColor = glm::vec3(0.5f * environmentBrightness);
+            auto spotLightDiffuseColor = glm::vec3(1.25f, 1.0f, 1.0f) * spotLightBrightness;
+            auto spotLightAmbientColor = glm::vec3(0.0f) * spotLightBrightness;
+            auto spotLightSpecularColor = glm::vec3(1.0f) * spotLightBrightness;
+            const float cutoff = glm::cos(glm::radians(12.5f));
+            const float outerCutoff = glm::cos(glm::radians(17.5f));
+
+            frameUniforms.view = view;
+            frameUniforms.projection = projection;
+            frameUniforms.viewPosition = camera.cameraPos;
+            frameUniformBuffer.setData(frameUniforms);
+
+            pointLights.clear();
+
+            for (const glm::vec3& position : pointLightPositions)
+            {
+                pointLights.push_back({ ambientColor, 0.0f, diffuseColor, 0.0f, specularColor, 0.0f, position, 10.0f });
+            }
 
-            ImGui::Begin("\"Inspector\"");
+            // small colored lights scattered over the floor, generated once and kept when the count changes
+            while (extraLightAnchors.size() < static_cast<size_t>(extraPointLightCount))
             {
-                int mouseInputMode = glfwGetInputMode(window, GLFW_CURSOR);
+                std::uniform_real_distribution<float> horizontal{ -10.0f, 10.0f };
+                std::uniform_real_distribution<float> vertical{ -0.4f, 2.0f };
+                std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
 
-                ImGui::Text("Mouse hovering on GUI: %s", mouseInputMode && io.WantCaptureMouse ? "True" : "False");
-                ImGui::Text("Mouse Pointer: %s", mouseInputMode == GLFW_CURSOR_NORMAL ? "Normal" : "Disabled");
+                const glm::vec3 color = glm::normalize(glm::vec3(unit(extraLightRandom), unit(extraLightRandom), unit(extraLightRandom)) + 0.05f);
+                const glm::vec3 anchor{ horizontal(extraLightRandom), vertical(extraLightRandom), horizontal(extraLightRandom) };
+                extraLightAnchors.push_back({ color * 0.02f, 0.0f, color, 0.0f, color, 0.0f, anchor, 1.0f + unit(extraLightRandom) * 1.5f });
+            }
+
+            extraLightAnchors.resize(static_cast<size_t>(extraPointLightCount));
+
+            const auto time = static_cast<float>(glfwGetTime());
+
+            for (size_t i = 0; i < extraLightAnchors.size(); i++)
+            {
+                PointLightData light = extraLightAnchors[i];
+                const float phase = static_cast<float>(i) * 0.37f;
+                light.position += glm::vec3(glm::sin(time + phase), 0.0f, glm::cos(time * 0.7f + phase)) * 0.5f;
+                pointLights.push_back(light);
+            }
 
-                ImGui::Text("Mouse Position: (%.2f, %.2f)", static_cast<double>(io.MousePos.x), static_cast<double>(io.MousePos.y));
-                ImGui::Text("Camera Position: (%.1f, %.1f, %.1f)", camera.cameraPos.x, camera.cameraPos.y, camera.cameraPos.z);
-                ImGui::Text("Camera Facing: (%.1f, %.1f, %.1f)", camera.cameraFront.x, camera.cameraFront.y, camera.cameraFront.z);
+            lightClusters.update(pointLights, camera);
+            lightClusters.bind();
 
-                ImGui::ColorEdit3("Background Color", reinterpret_cast<float*>(&clearColor));
+            lightUniforms.pointLightCount = static_cast<int>(std::min<size_t>(pointLights.size(), LearnOpenGL::Graphics::MaxPointLights));
+            std::copy_n(pointLights.begin(), lightUniforms.pointLightCount, lightUniforms.pointLights);
+
+            lightUniforms.directionalLight.direction = Vector3::Down + Vector3::Forward;
+            lightUniforms.directionalLight.ambient = ambientColor;
+            lightUniforms.directionalLight.diffuse = diffuseColor;
+            lightUniforms.directionalLight.specular = specularColor;
+            lightUniforms.spotLight.position = spotLightPosition;
+            lightUniforms.spotLight.direction = spotLightDirection + (Vector3::Forward * spotLightAngle);
+            lightUniforms.spotLight.cutoff = cutoff;
+            lightUniforms.spotLight.outerCutoff = outerCutoff;
+
+            if (enableSpotLight)
+            {
+                lightUniforms.spotLight.ambient = spotLightAmbientColor;
+                lightUniforms.spotLight.diffuse = spotLightDiffuseColor;
+                lightUniforms.spotLight.specular = spotLightSpecularColor;
+            }
+            else
+            {
+                lightUniforms.spotLight.ambient = Vector3::Zero;
+                lightUniforms.spotLight.diffuse = Vector3::Zero;
+                lightUniforms.spotLight.specular = Vector3::Zero;
+            }
 
-                if (ImGui::Button("Reset Player Position"))
+            lightUniformBuffer.setData(lightUniforms);
+
+            // the spotlight is compiled out of the variants while it is off. The light loop stops at pointLightCount anyway,
+            // so its bound stays fixed rather than building a variant for every light count the slider passes through
+            const ShaderPermutation scenePermutation{
+                (enableSpotLight ? LearnOpenGL::Graphics::ShaderFeatureSpotLight : 0u)
+                | (enableClusteredLighting ? LearnOpenGL::Graphics::ShaderFeatureClusteredLights : 0u),
+                enableClusteredLighting ? 0u : static_cast<uint32_t>(LearnOpenGL::Graphics::MaxPointLights) };
+
+            // deferred shading draws the same geometry into the G-buffer, lighting it in one pass afterwards
+            if (enableDeferredShading)
+            {
+                deferredRenderer.beginGeometryPass();
+            }
+
+            ShaderVariants& sceneModelShaders = enableDeferredShading ? gBufferModelShaders : modelShaders;
+            const ShaderPermutation& sceneModelPermutation = enableDeferredShading ? gBufferPermutation : scenePermutation;
+            const PlaneProgram& planeProgram = enableDeferredShading ? gBufferPlaneProgram : forwardPlaneProgram;
+
+            planeProgram.shader->use();
+            planeProgram.shader->setFloat(planeProgram.shininess, 32.0f);
+            // the render queue leaves its last model matrix set
+            planeProgram.shader->setMat4(planeProgram.model, glm::mat4(1.0f));
+            planeProgram.shader->setMat3(planeProgram.normalMatrix, glm::mat3(1.0f));
+            planeProgram.shader->setBool(planeProgram.compactVertices, false);
+            planeProgram.shader->setBool(planeProgram.useTextureArrays, false);
+
+            GLStateCache::bindVertexArray(planeVao);
+            floorTexture.use(GL_TEXTURE0);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+            const Frustum frustum{ camera.viewProjection() };
+            renderQueue.setView(camera.cameraPos, frustum);
+            renderQueue.setCullingEnabled(enableFrustumCulling);
+
+            Transform modelTransform{};
+            Transform modelTransform2{};
+            modelTransform2.translate(Vector3::Forward * 5.0f);
+
+            LearnOpenGL::Model::MultiDrawStats multiDrawStats{};
+
+            if (enableMultiDraw)
+            {
+                // a batch may mix 2D textures and arrays, so this variant keeps both paths
+                const Shader& multiDrawShader = sceneModelShaders.get({ sceneModelPermutation.features
+                                                                        | LearnOpenGL::Graphics::ShaderFeatureDrawTable
+                                                                        | LearnOpenGL::Graphics::ShaderFeatureTextures2D
+                                                                        | LearnOpenGL::Graphics::ShaderFeatureTextureArrays,
+                                                                        sceneModelPermutation.pointLights });
+                multiDrawShader.use();
+
+                // one call per batch of meshes sharing textures, bypassing the render queue
+                for (const auto& [model, transform] : { std::pair{ testModel.get(), &modelTransform }, std::pair{ testModel2.get(), &modelTransform2 } })
                 {
-                    camera.cameraPos = Vector3::Forward * 3.0f;
-                    camera.cameraFront = Vector3::Back;
-                    camera.cameraUp = Vector3::Up;
+                    const auto stats = enableFrustumCulling
+                        ? model->multiDraw(multiDrawShader, transform->get(), transform->getNormalMatrix(), frustum)
+                        : model->multiDraw(multiDrawShader, transform->get(), transform->getNormalMatrix());
+
+                    multiDrawStats.drawCalls += stats.drawCalls;
+                    multiDrawStats.meshesDrawn += stats.meshesDrawn;
+                    multiDrawStats.meshesCulled += stats.meshesCulled;
                 }
+            }
+            else
+            {
+                testModel->submit(renderQueue, sceneModelShaders, sceneModelPermutation, modelTransform);
+                testModel2->submit(renderQueue, sceneModelShaders, sceneModelPermutation, modelTransform2);
+            }
+
+            renderQueue.flush();
 
-                ImGui::Checkbox("Toggle Point Light (or press F)", &enableSpotLight);
-                ImGui::SliderFloat("Environment Brightness", &environmentBrightness, 0.0f, 1.0f);
-                ImGui::SliderFloat3("Spotlight Position", value_ptr(spotLightPosition), -10.0f, 10.0f);
-                ImGui::SliderFloat("Spotlight Angle", &spotLightAngle, -1.0f, 1.0f);
-                ImGui::SameLine();
-                ImGui::InputFloat("(Edit angle)", &spotLightAngle);
-                ImGui::SliderFloat("Spotlight Brightness", &spotLightBrightness, 0.0f, 1.0f);
+            if (instanceTransforms.size() != static_cast<size_t>(instancedModelCount))
+            {
+                // lay the copies out on a square grid behind the scene
+                const auto gridWidth = static_cast<int>(glm::ceil(glm::sqrt(static_cast<float>(instancedModelCount))));
+                instanceTransforms.resize(instancedModelCount);
 
-                ImGui::Text("Render Time: %.3f ms/frame (%.1f FPS)", static_cast<double>(1000.0f / ImGui::GetIO().Framerate),
-                            static_cast<double>(ImGui::GetIO().Framerate));
+                for (int i = 0; i < instancedModelCount; i++)
+                {
+                    Transform instanceTransform{};
+                    instanceTransform.translate(glm::vec3(static_cast<float>(i % gridWidth - gridWidth / 2) * 4.0f, 0.0f,
+                                                          -10.0f - static_cast<float>(i / gridWidth) * 4.0f));
+                    instanceTransforms[i] = instanceTransform.get();
+                }
             }
-            ImGui::End();
 
-            ImGui::Begin("Scene View");
+            size_t visibleInstances = 0;
+
+            if (!instanceTransforms.empty())
             {
-                ImGui::BeginChild("Yeet");
-                // Get the current cursor position (where your window is)
-                ImVec2 currentCursorPosition = ImGui::GetWindowSize();
-                ImGui::Image(reinterpret_cast<void*>(textureColorBuffer), currentCursorPosition, ImVec2(0, 1), ImVec2(1, 0));
-                hoveredOverScene = (ImGui::IsItemHovered() || glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED);
+                const Shader& instancedProgram = enableDeferredShading ? instancedGBufferShader : instancedShader;
+                instancedProgram.use();
+                instancedProgram.setFloat(enableDeferredShading ? instancedGBufferShininessUniform : instancedShininessUniform, 32.0f);
+
+                if (enableFrustumCulling)
+                {
+                    visibleInstances = testModel->drawInstanced(instancedProgram, instanceTransforms, frustum);
+                }
+                else
+                {
+                    testModel->drawInstanced(instancedProgram, instanceTransforms);
+                    visibleInstances = instanceTransforms.size();
+                }
+            }
+
+            if (enableDeferredShading)
+            {
+                deferredRenderer.lightingPass(deferredLightingShaders.get(scenePermutation), sceneFramebuffer, camera.viewProjection());
+            }
+
+            GLStateCache::bindVertexArray(0);
+
+            GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            ImGui::SetNextWindowPos(ImVec2{ 0.0f, 0.0f }, ImGuiCond_Once);
+            ImGui::SetNextWindowSize(ImVec2{ static_cast<float>(windowWidth), static_cast<float>(windowHeight) }, ImGuiCond_Once);
+            ImGui::Begin("how does this even begin to qualify as a game engine");
+            {
+                ImGui::BeginChild("Engine Content");
+
+                ImGui::Begin("\"Inspector\"");
+                {
+                    int mouseInputMode = glfwGetInputMode(window, GLFW_CURSOR);
+
+                    ImGui::Text("Mouse hovering on GUI: %s", mouseInputMode && io.WantCaptureMouse ? "True" : "False");
+                    ImGui::Text("Mouse Pointer: %s", mouseInputMode == GLFW_CURSOR_NORMAL ? "Normal" : "Disabled");
+
+                    ImGui::Text("Mouse Position: (%.2f, %.2f)", static_cast<double>(io.MousePos.x), static_cast<double>(io.MousePos.y));
+                    ImGui::Text("Camera Position: (%.1f, %.1f, %.1f)", camera.cameraPos.x, camera.cameraPos.y, camera.cameraPos.z);
+                    ImGui::Text("Camera Facing: (%.1f, %.1f, %.1f)", camera.cameraFront.x, camera.cameraFront.y, camera.cameraFront.z);
+
+                    ImGui::ColorEdit3("Background Color", reinterpret_cast<float*>(&clearColor));
+
+                    if (ImGui::Button("Reset Player Position"))
+                    {
+                        camera.cameraPos = Vector3::Forward * 3.0f;
+                        camera.cameraFront = Vector3::Back;
+                        camera.cameraUp = Vector3::Up;
+                    }
+
+                    ImGui::Checkbox("Toggle Point Light (or press F)", &enableSpotLight);
+                    ImGui::SliderFloat("Environment Brightness", &environmentBrightness, 0.0f, 1.0f);
+                    ImGui::SliderFloat3("Spotlight Position", value_ptr(spotLightPosition), -10.0f, 10.0f);
+                    ImGui::SliderFloat("Spotlight Angle", &spotLightAngle, -1.0f, 1.0f);
+                    ImGui::SameLine();
+                    ImGui::InputFloat("(Edit angle)", &spotLightAngle);
+                    ImGui::SliderFloat("Spotlight Brightness", &spotLightBrightness, 0.0f, 1.0f);
+                    ImGui::SliderInt("Instanced Backpacks", &instancedModelCount, 0, 10000);
+                    ImGui::Checkbox("Frustum Culling", &enableFrustumCulling);
+                    ImGui::Checkbox("Multi-Draw Models", &enableMultiDraw);
+                    ImGui::Checkbox("Clustered Lighting", &enableClusteredLighting);
+                    ImGui::Checkbox("Deferred Shading", &enableDeferredShading);
+                    ImGui::SliderInt("Extra Point Lights", &extraPointLightCount, 0, 4096);
+                    ImGui::SliderFloat("Model Load Budget (ms/frame)", &modelLoadBudgetMilliseconds, 0.5f, 16.0f);
+
+                    if (ImGui::SliderInt("Upload Budget (MiB/frame)", &uploadBudgetMebibytes, 1, 64))
+                    {
+                        UploadScheduler::getShared().setFrameBudget(static_cast<size_t>(uploadBudgetMebibytes) * 1024 * 1024);
+                    }
+
+                    for (const auto& [name, model] : { std::pair{ "Backpack", testModel.get() }, std::pair{ "Car", testModel2.get() } })
+                    {
+                        if (!model->isLoaded())
+                        {
+                            const auto progress = model->getLoadProgress();
+                            const std::string overlay = std::string(name).append(": ").append(progress.getStageName());
+                            ImGui::ProgressBar(progress.getFraction(), ImVec2{ -1.0f, 0.0f }, overlay.c_str());
+                        }
+                    }
+
+                    ImGui::Text("Render Time: %.3f ms/frame (%.1f FPS, %s shading)", static_cast<double>(1000.0f / ImGui::GetIO().Framerate),
+                                static_cast<double>(ImGui::GetIO().Framerate), enableDeferredShading ? "deferred" : "forward");
+
+                    const auto stateStats = GLStateCache::getFrameStats();
+                    ImGui::Text("GL State Changes: %zu issued, %zu skipped (programs %zu/%zu, vertex arrays %zu/%zu, textures %zu/%zu)",
+                                stateStats.getTotalIssued(), stateStats.getTotalSkipped(), stateStats.programs.issued,
+                                stateStats.programs.skipped, stateStats.vertexArrays.issued, stateStats.vertexArrays.skipped,
+                                stateStats.textures.issued, stateStats.textures.skipped);
+
+                    const auto queueStats = renderQueue.getStats();
+                    ImGui::Text("Render Queue: %zu draws, state changes submitted/sorted: shaders %zu/%zu, materials %zu/%zu, "
+                                "vertex arrays %zu/%zu", queueStats.drawItems, queueStats.submissionOrder.shaders,
+                                queueStats.sorted.shaders, queueStats.submissionOrder.materials, queueStats.sorted.materials,
+                                queueStats.submissionOrder.vertexArrays, queueStats.sorted.vertexArrays);
+
+                    ImGui::Text("Multi-Draw: %zu calls for %zu meshes (%s)", multiDrawStats.drawCalls, multiDrawStats.meshesDrawn,
+                                GLExtensions::supportsMultiDrawIndirect() ? "indirect" : "base vertex fallback");
+
+                    // multi-draw culls the models itself, leaving the render queue empty
+                    ImGui::Text("Frustum Culling: %zu meshes visible, %zu culled; %zu/%zu instances visible",
+                                enableMultiDraw ? multiDrawStats.meshesDrawn : queueStats.drawItems,
+                                enableMultiDraw ? multiDrawStats.meshesCulled : queueStats.culled, visibleInstances,
+                                instanceTransforms.size());
+
+                    const auto geometryStats = LearnOpenGL::Model::GeometryArena::getShared().getStats();
+                    ImGui::Text("Geometry Arena: %zu meshes, vertices %.1f/%.1f MiB, indices %.1f/%.1f MiB", geometryStats.allocations,
+                                static_cast<double>(geometryStats.vertexBytesUsed) / (1024.0 * 1024.0),
+                                static_cast<double>(geometryStats.vertexBytesCapacity) / (1024.0 * 1024.0),
+                                static_cast<double>(geometryStats.indexBytesUsed) / (1024.0 * 1024.0),
+                                static_cast<double>(geometryStats.indexBytesCapacity) / (1024.0 * 1024.0));
+
+                    const auto textureStats = LearnOpenGL::Graphics::TextureRegistry::getStats();
+                    ImGui::Text("Textures: %zu resident (%.1f MiB), %zu hits, %zu content hits, %zu misses", textureStats.textureCount,
+                                static_cast<double>(textureStats.bytesResident) / (1024.0 * 1024.0), textureStats.hits,
+                                textureStats.contentHits, textureStats.misses);
+
+                    const auto ringStats = DynamicRingBuffer::getShared().getStats();
+                    ImGui::Text("Dynamic Ring Buffer: %.1f/%.1f KiB per frame, %zu stalls (%s)",
+                                static_cast<double>(ringStats.bytesLastFrame) / 1024.0, static_cast<double>(ringStats.frameCapacity) / 1024.0,
+                                ringStats.stalls, ringStats.persistent ? "persistent" : "unsynchronized maps");
+
+                    const auto shaderCacheStats = ShaderCache::getStats();
+                    ImGui::Text("Shader Cache: %zu hits, %zu misses (%zu rejected), compiled in %.1f ms, loaded in %.1f ms, %.1f ms saved",
+                                shaderCacheStats.hits, shaderCacheStats.misses, shaderCacheStats.rejected,
+                                shaderCacheStats.compileMilliseconds, shaderCacheStats.loadMilliseconds, shaderCacheStats.millisecondsSaved);
+                    ImGui::Text("Shader Variants: %zu built", modelShaders.getVariantCount());
+
+                    const auto& clusterStats = lightClusters.getStats();
+                    ImGui::Text("Light Clusters: %zu/%zu lights visible, %zu/%u clusters lit, %zu references (max %zu per cluster), "
+                                "assigned in %.2f ms", clusterStats.visibleLights, clusterStats.lights, clusterStats.litClusters,
+                                LightClusters::ClusterCount, clusterStats.lightReferences, clusterStats.maxClusterLights,
+                                clusterStats.assignMilliseconds);
+
+                    const auto uploadStats = UploadScheduler::getShared().getStats();
+                    ImGui::Text("Uploads: %zu jobs queued (%.1f MiB), %.2f MiB this frame, latency %.1f ms avg, %.1f ms max",
+                                uploadStats.queuedJobs, static_cast<double>(uploadStats.queuedBytes) / (1024.0 * 1024.0),
+                                static_cast<double>(uploadStats.bytesThisFrame) / (1024.0 * 1024.0),
+                                uploadStats.averageLatencyMilliseconds, uploadStats.maxLatencyMilliseconds);
+                }
+                ImGui::End();
+
+                ImGui::Begin("Scene View");
+                {
+                    ImGui::BeginChild("Yeet");
+                    // Get the current cursor position (where your window is)
+                    ImVec2 currentCursorPosition = ImGui::GetWindowSize();
+                    ImGui::Image(reinterpret_cast<void*>(static_cast<uintptr_t>(sceneFramebuffer.getColorTexture(0))), currentCursorPosition, ImVec2(0, 1), ImVec2(1, 0));
+                    hoveredOverScene = (ImGui::IsItemHovered() || glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED);
+
+                    ImGui::GetForegroundDrawList()->AddRect({ 0, 0 }, ImGui::GetWindowSize(), ImColor{ 255, 0, 0 });
+                    ImGui::EndChild();
+                }
+                ImGui::End();
 
-                ImGui::GetForegroundDrawList()->AddRect({ 0, 0 }, ImGui::GetWindowSize(), ImColor{ 255, 0, 0 });
                 ImGui::EndChild();
             }
             ImGui::End();
 
-            ImGui::EndChild();
-        }
-        ImGui::End();
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            // ImGui's renderer binds its own program, vertex array and font texture
+            GLStateCache::invalidate();
 
-        // Update and Render additional Platform Windows
-        // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
-        //  For this specific demo app we could also call glfwMakeContextCurrent(window) directly)
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-        {
-            GLFWwindow* backup_current_context = glfwGetCurrentContext();
-            ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
-            glfwMakeContextCurrent(backup_current_context);
+            // Update and Render additional Platform Windows
+            // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
+            //  For this specific demo app we could also call glfwMakeContextCurrent(window) directly)
+            if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+            {
+                GLFWwindow* backup_current_context = glfwGetCurrentContext();
+                ImGui::UpdatePlatformWindows();
+                ImGui::RenderPlatformWindowsDefault();
+                glfwMakeContextCurrent(backup_current_context);
+            }
+
+            DynamicRingBuffer::getShared().endFrame();
+            glfwSwapBuffers(window);
         }
 
-        glfwSwapBuffers(window);
+        glDeleteProgram(shader.getId());
     }
 
-    glDeleteProgram(shader.getId());
-    glDeleteFramebuffers(1, &fbo);
-
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
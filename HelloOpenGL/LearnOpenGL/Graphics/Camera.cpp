@@ -1,6 +1,5 @@
 ﻿#include "Camera.h"
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -17,7 +16,18 @@ namespace LearnOpenGL::Graphics
           _fov(DefaultFov),
           _nearClip(DefaultNearClip),
           _farClip(DefaultFarClip),
-          _worldUp(DefaultUp)
+          _viewportWidth(0),
+          _viewportHeight(0),
+          _worldUp(DefaultUp),
+          _viewPos(),
+          _viewFront(),
+          _viewUp(),
+          _isViewDirty(true),
+          _isProjectionDirty(true),
+          _isViewProjectionDirty(true),
+          _viewCache(1.0f),
+          _projectionCache(1.0f),
+          _viewProjectionCache(1.0f)
     {
         updateCameraVectors();
     }
@@ -37,42 +47,92 @@ namespace LearnOpenGL::Graphics
         return _farClip;
     }
 
+    float Camera::getAspectRatio() const
+    {
+        if (_viewportWidth <= 0 || _viewportHeight <= 0)
+        {
+            return 0.0f;
+        }
+
+        return static_cast<float>(_viewportWidth) / static_cast<float>(_viewportHeight);
+    }
+
+    int Camera::getViewportWidth() const
+    {
+        return _viewportWidth;
+    }
+
+    int Camera::getViewportHeight() const
+    {
+        return _viewportHeight;
+    }
+
     glm::mat4 Camera::calculateView() const
     {
-        return lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        updateView();
+        return _viewCache;
     }
 
     glm::mat4 Camera::calculateProjection() const
     {
-        // Get information about the viewport, to make sure the projection is calculated correctly.
-        // https://www.khronos.org/registry/OpenGL-Refpages/es2.0/xhtml/glViewport.xml
-        // viewportData[2] and [3] contain the width and height of the viewport.
-        // Inspired by https://github.com/wmcnamara/crynn/
+        if (_isProjectionDirty)
+        {
+            // the viewport used to be read back with glGetFloatv every frame, which can stall on the driver
+            const float aspectRatio = getAspectRatio();
+
+            _projectionCache = aspectRatio > 0.0f
+                                   ? glm::perspective(glm::radians(_fov), aspectRatio, _nearClip, _farClip)
+                                   : glm::mat4(1.0f);
+            _isProjectionDirty = false;
+            _isViewProjectionDirty = true;
+        }
 
-        float viewportData[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-        glGetFloatv(GL_VIEWPORT, viewportData);
+        return _projectionCache;
+    }
 
-        const float windowWidth = viewportData[2];
-        const float windowHeight = viewportData[3];
-        const float aspectRatio = windowWidth / windowHeight;
+    glm::mat4 Camera::viewProjection() const
+    {
+        updateView();
+        const glm::mat4 projection = calculateProjection();
 
-        if (windowWidth <= 0.0f || windowHeight <= 0.0f)
+        if (_isViewProjectionDirty)
         {
-            return glm::mat4(1.0f);
+            _viewProjectionCache = projection * _viewCache;
+            _isViewProjectionDirty = false;
         }
 
-        return glm::perspective(glm::radians(_fov), aspectRatio, _nearClip, _farClip);
+        return _viewProjectionCache;
     }
 
     void Camera::setFov(const float fov)
     {
-        _fov = glm::clamp(fov, MinFov, MaxFov);
+        const float clampedFov = glm::clamp(fov, MinFov, MaxFov);
+
+        if (clampedFov != _fov)
+        {
+            _fov = clampedFov;
+            _isProjectionDirty = true;
+        }
     }
 
     void Camera::setClip(const float nearClip, const float farClip)
     {
-        _nearClip = nearClip;
-        _farClip = farClip;
+        if (nearClip != _nearClip || farClip != _farClip)
+        {
+            _nearClip = nearClip;
+            _farClip = farClip;
+            _isProjectionDirty = true;
+        }
+    }
+
+    void Camera::setViewport(const int width, const int height)
+    {
+        if (width != _viewportWidth || height != _viewportHeight)
+        {
+            _viewportWidth = width;
+            _viewportHeight = height;
+            _isProjectionDirty = true;
+        }
     }
 
     void Camera::updateCameraVectors()
@@ -86,5 +146,22 @@ namespace LearnOpenGL::Graphics
         cameraFront = front;
         cameraRight = normalize(cross(cameraFront, _worldUp));
         cameraUp = normalize(cross(cameraRight, cameraFront));
+        _isViewDirty = true;
+    }
+
+    void Camera::updateView() const
+    {
+        if (!_isViewDirty && _viewPos == cameraPos && _viewFront == cameraFront && _viewUp == cameraUp)
+        {
+            return;
+        }
+
+        _viewPos = cameraPos;
+        _viewFront = cameraFront;
+        _viewUp = cameraUp;
+        _viewCache = lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+
+        _isViewDirty = false;
+        _isViewProjectionDirty = true;
     }
 }
@@ -38,12 +38,19 @@ namespace LearnOpenGL::Graphics
         [[nodiscard]] float getFov() const;
         [[nodiscard]] float getNearClip() const;
         [[nodiscard]] float getFarClip() const;
+        [[nodiscard]] float getAspectRatio() const;
+        [[nodiscard]] int getViewportWidth() const;
+        [[nodiscard]] int getViewportHeight() const;
 
+        // Matrices are cached and only rebuilt after the camera vectors, fov, clip planes or viewport change.
         [[nodiscard]] glm::mat4 calculateView() const;
         [[nodiscard]] glm::mat4 calculateProjection() const;
+        [[nodiscard]] glm::mat4 viewProjection() const;
 
         void setFov(float fov);
         void setClip(float nearClip, float farClip);
+        // Size of the viewport the camera renders into; the projection is the identity until it is set.
+        void setViewport(int width, int height);
 
         void updateCameraVectors();
 
@@ -51,8 +58,24 @@ namespace LearnOpenGL::Graphics
         float _fov;
         float _nearClip;
         float _farClip;
+        int _viewportWidth;
+        int _viewportHeight;
 
         glm::vec3 _worldUp;
+
+        // cameraPos/cameraFront/cameraUp are public, so the view is checked against the vectors it was built from
+        mutable glm::vec3 _viewPos;
+        mutable glm::vec3 _viewFront;
+        mutable glm::vec3 _viewUp;
+        mutable bool _isViewDirty;
+        mutable bool _isProjectionDirty;
+        mutable bool _isViewProjectionDirty;
+
+        mutable glm::mat4 _viewCache;
+        mutable glm::mat4 _projectionCache;
+        mutable glm::mat4 _viewProjectionCache;
+
+        void updateView() const;
     };
 }
 #endif
@@ -0,0 +1,82 @@
+﻿#include "DeferredRenderer.h"
+
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+
+namespace LearnOpenGL::Graphics
+{
+    DeferredRenderer::DeferredRenderer(const int width, const int height)
+        : _gBuffer(width, height,
+                   {
+                       { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_NEAREST },
+                       { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_NEAREST },
+                       { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_NEAREST },
+                       { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_NEAREST }
+                   },
+                   FramebufferDepth::Texture)
+    {
+        glGenVertexArrays(1, &_emptyVertexArray);
+    }
+
+    DeferredRenderer::~DeferredRenderer()
+    {
+        GLStateCache::onVertexArrayDeleted(_emptyVertexArray);
+        glDeleteVertexArrays(1, &_emptyVertexArray);
+    }
+
+    void DeferredRenderer::resize(const int width, const int height)
+    {
+        _gBuffer.resize(width, height);
+    }
+
+    void DeferredRenderer::beginGeometryPass() const
+    {
+        _gBuffer.bind();
+
+        // zero everywhere, and depth 1 marks pixels the lighting pass leaves alone
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+
+    void DeferredRenderer::lightingPass(const Shader& lightingShader, const Framebuffer& target, const glm::mat4& viewProjection) const
+    {
+        target.bind();
+
+        for (unsigned int i = 0; i < GBufferTargetCount; i++)
+        {
+            GLStateCache::bindTexture(GL_TEXTURE0 + i, GL_TEXTURE_2D, _gBuffer.getColorTexture(i));
+        }
+
+        GLStateCache::bindTexture(GL_TEXTURE0 + DepthTextureUnit, GL_TEXTURE_2D, _gBuffer.getDepthTexture());
+
+        lightingShader.use();
+        lightingShader.setMat4("inverseViewProjection", glm::inverse(viewProjection));
+
+        GLStateCache::disable(GL_DEPTH_TEST);
+        GLStateCache::bindVertexArray(_emptyVertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        GLStateCache::enable(GL_DEPTH_TEST);
+
+        GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, _gBuffer.getId());
+        GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, target.getId());
+        glBlitFramebuffer(0, 0, _gBuffer.getWidth(), _gBuffer.getHeight(), 0, 0, target.getWidth(), target.getHeight(),
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        target.bind();
+    }
+
+    const Framebuffer& DeferredRenderer::getGBuffer() const
+    {
+        return _gBuffer;
+    }
+
+    void DeferredRenderer::setupSamplerUnits(const Shader& lightingShader)
+    {
+        lightingShader.use();
+        lightingShader.setInt("gAlbedo", AlbedoTarget);
+        lightingShader.setInt("gNormal", NormalTarget);
+        lightingShader.setInt("gSpecular", SpecularTarget);
+        lightingShader.setInt("gEmission", EmissionTarget);
+        lightingShader.setInt("gDepth", static_cast<int>(DepthTextureUnit));
+    }
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include <glm/glm.hpp>
+
+#include "Framebuffer.h"
+#include "Shader.h"
+
+namespace LearnOpenGL::Graphics
+{
+    // Deferred shading: opaque geometry is drawn once into a G-buffer (gbuffer.frag), then a single fullscreen pass
+    // (deferred_lighting.frag) lights every pixel exactly once, however much overdraw the geometry had.
+    class DeferredRenderer
+    {
+    public:
+        // color targets of the G-buffer, in the order gbuffer.frag writes them
+        enum GBufferTarget
+        {
+            // diffuse color with the texture sample added, clamped
+            AlbedoTarget,
+            // world-space normal
+            NormalTarget,
+            // specular color in rgb, shininess / MAX_SHININESS in alpha
+            SpecularTarget,
+            // unclamped like the forward path adds it, hence a float target
+            EmissionTarget,
+            GBufferTargetCount
+        };
+
+        // the lighting pass reads the targets from units 0-3 and depth from unit 4
+        static constexpr unsigned int DepthTextureUnit = GBufferTargetCount;
+
+        DeferredRenderer(int width, int height);
+        DeferredRenderer(const DeferredRenderer&) = delete;
+        DeferredRenderer(DeferredRenderer&&) = delete;
+
+        DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+        DeferredRenderer& operator=(DeferredRenderer&&) = delete;
+
+        ~DeferredRenderer();
+
+        void resize(int width, int height);
+        // Binds and clears the G-buffer. Draw the opaque scene with gbuffer.frag programs afterwards.
+        void beginGeometryPass() const;
+        // Lights the G-buffer into target, leaving target bound. Pixels no geometry covered keep target's contents,
+        // and the G-buffer's depth is copied over so anything drawn forward afterwards is still depth tested.
+        void lightingPass(const Shader& lightingShader, const Framebuffer& target, const glm::mat4& viewProjection) const;
+
+        [[nodiscard]] const Framebuffer& getGBuffer() const;
+
+        // Points the G-buffer samplers at their units. Needed once per lighting shader before its first draw.
+        static void setupSamplerUnits(const Shader& lightingShader);
+
+    private:
+        Framebuffer _gBuffer;
+        // the fullscreen triangle is generated from gl_VertexID, but core profiles refuse to draw without a vertex array
+        unsigned int _emptyVertexArray{};
+    };
+}
+
+#endif // DEFERRED_RENDERER_H
@@ -0,0 +1,193 @@
+﻿#include "DynamicRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GLExtensions.h"
+
+namespace LearnOpenGL::Graphics
+{
+    DynamicRingBuffer& DynamicRingBuffer::getShared()
+    {
+        static DynamicRingBuffer ringBuffer;
+        return ringBuffer;
+    }
+
+    GLintptr DynamicRingBuffer::write(const void* data, const size_t size, const size_t alignment)
+    {
+        if (size == 0)
+        {
+            return -1;
+        }
+
+        size_t offset = (_head + alignment - 1) / alignment * alignment;
+
+        if (_buffer == 0 || offset + size > _frameCapacity)
+        {
+            // the old buffer is still read by this frame's earlier draws and bindings, they keep it alive
+            createBuffer(std::max({ _frameCapacity * 2, offset + size, InitialFrameCapacity }));
+
+            if (_buffer == 0)
+            {
+                return -1;
+            }
+
+            offset = 0;
+        }
+
+        if (!_frameFenceWaited)
+        {
+            waitForFrame();
+        }
+
+        const size_t bufferOffset = _frame * _frameCapacity + offset;
+
+        if (_mapped)
+        {
+            // coherent, so the GPU sees the bytes without a flush
+            std::memcpy(_mapped + bufferOffset, data, size);
+        }
+        else
+        {
+            // the fence already guarantees the GPU is done with this range
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+
+            if (void* mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(bufferOffset), static_cast<GLsizeiptr>(size),
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT))
+            {
+                std::memcpy(mapped, data, size);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            }
+            else
+            {
+                glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(bufferOffset), static_cast<GLsizeiptr>(size), data);
+            }
+        }
+
+        _head = offset + size;
+        return static_cast<GLintptr>(bufferOffset);
+    }
+
+    void DynamicRingBuffer::endFrame()
+    {
+        if (_head > 0)
+        {
+            _fences[_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        if (!_retiredBuffers.empty())
+        {
+            glDeleteBuffers(static_cast<GLsizei>(_retiredBuffers.size()), _retiredBuffers.data());
+            _retiredBuffers.clear();
+        }
+
+        _lastFrameBytes = _head;
+        _frame = (_frame + 1) % FrameCount;
+        _head = 0;
+        _frameFenceWaited = false;
+    }
+
+    GLuint DynamicRingBuffer::getId() const
+    {
+        return _buffer;
+    }
+
+    size_t DynamicRingBuffer::getUniformAlignment()
+    {
+        static const size_t alignment = []
+        {
+            GLint value = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+            return static_cast<size_t>(std::max(value, 1));
+        }();
+
+        return alignment;
+    }
+
+    DynamicRingBufferStats DynamicRingBuffer::getStats() const
+    {
+        return { _lastFrameBytes, _frameCapacity, _stalls, _mapped != nullptr };
+    }
+
+    void DynamicRingBuffer::createBuffer(const size_t frameCapacity)
+    {
+        if (_buffer != 0)
+        {
+            _retiredBuffers.push_back(_buffer);
+            _buffer = 0;
+            _mapped = nullptr;
+        }
+
+        // fences of the old buffer guard nothing in the new one
+        for (GLsync& fence : _fences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        glGenBuffers(1, &_buffer);
+
+        if (!_buffer)
+        {
+            std::cerr << "Failed to generate dynamic ring buffer\n";
+            _frameCapacity = 0;
+            return;
+        }
+
+        _frameCapacity = frameCapacity;
+        _head = 0;
+        _frameFenceWaited = true;
+
+        const auto size = static_cast<GLsizeiptr>(_frameCapacity * FrameCount);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+
+        if (GLExtensions::supportsBufferStorage())
+        {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | MapPersistentBit | MapCoherentBit;
+            GLExtensions::bufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+            _mapped = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+
+            if (_mapped)
+            {
+                return;
+            }
+
+            // immutable storage cannot be respecified, so the fallback needs a buffer of its own
+            std::cerr << "Failed to map dynamic ring buffer persistently, falling back to unsynchronized maps\n";
+            _retiredBuffers.push_back(_buffer);
+            glGenBuffers(1, &_buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+        }
+
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+
+    void DynamicRingBuffer::waitForFrame()
+    {
+        _frameFenceWaited = true;
+        GLsync& fence = _fences[_frame];
+
+        if (!fence)
+        {
+            return;
+        }
+
+        // normally signaled long ago, since the region was last written FrameCount frames back
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            _stalls++;
+
+            if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_WAIT_FAILED)
+            {
+                std::cerr << "Waiting on a dynamic ring buffer region failed.\n";
+            }
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -0,0 +1,79 @@
+﻿#pragma once
+#ifndef DYNAMIC_RING_BUFFER_H
+#define DYNAMIC_RING_BUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+namespace LearnOpenGL::Graphics
+{
+    struct DynamicRingBufferStats
+    {
+        size_t bytesLastFrame;
+        // per frame; the buffer holds FrameCount times this
+        size_t frameCapacity;
+        // frames whose writes had to wait on the GPU still reading that part of the buffer
+        size_t stalls;
+        bool persistent;
+    };
+
+    // One buffer split into FrameCount regions, each written during one frame and fenced at its end, so per-frame data
+    // (instance matrices, uniform blocks, indirect commands) is written while the GPU still reads the previous frames'
+    // regions, without the driver synchronizing. The buffer stays mapped when buffer storage is available; otherwise
+    // every write maps its range unsynchronized. Only use from the thread owning the GL context.
+    class DynamicRingBuffer
+    {
+    public:
+        static constexpr size_t FrameCount = 3;
+        static constexpr size_t InitialFrameCapacity = 1024 * 1024;
+        // enough for vertex attributes and std140 data
+        static constexpr size_t DefaultAlignment = 16;
+
+        DynamicRingBuffer() = default;
+        DynamicRingBuffer(const DynamicRingBuffer&) = delete;
+        DynamicRingBuffer& operator=(const DynamicRingBuffer&) = delete;
+
+        // Buffer all per-frame data is written to, created on first use.
+        static DynamicRingBuffer& getShared();
+
+        // Copies data into this frame's region and returns its offset, or -1 if nothing could be written.
+        // A write that does not fit grows the buffer, which gives it a new name, so read getId() after writing.
+        GLintptr write(const void* data, size_t size, size_t alignment = DefaultAlignment);
+
+        template <typename T>
+        GLintptr write(const std::vector<T>& data, const size_t alignment = DefaultAlignment)
+        {
+            return write(data.data(), sizeof(T) * data.size(), alignment);
+        }
+
+        // Fences this frame's writes and moves on to the next region. Call once per frame, after the last draw.
+        void endFrame();
+
+        [[nodiscard]] GLuint getId() const;
+        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, which glBindBufferRange offsets for uniform blocks have to be a multiple of
+        [[nodiscard]] static size_t getUniformAlignment();
+        [[nodiscard]] DynamicRingBufferStats getStats() const;
+
+    private:
+        GLuint _buffer{};
+        std::byte* _mapped{};
+        size_t _frameCapacity{};
+        size_t _frame = 0;
+        size_t _head = 0;
+        // signaled once the GPU is done with the region written during that frame
+        std::array<GLsync, FrameCount> _fences{};
+        bool _frameFenceWaited = false;
+        // buffers replaced by a larger one this frame, deleted once nothing binds them for this frame's draws anymore
+        std::vector<GLuint> _retiredBuffers;
+
+        size_t _lastFrameBytes = 0;
+        size_t _stalls = 0;
+
+        void createBuffer(size_t frameCapacity);
+        void waitForFrame();
+    };
+}
+
+#endif // DYNAMIC_RING_BUFFER_H
@@ -0,0 +1,159 @@
+﻿#include "Framebuffer.h"
+
+#include <iostream>
+#include <utility>
+
+#include "GLStateCache.h"
+
+namespace LearnOpenGL::Graphics
+{
+    Framebuffer::Framebuffer(const int width, const int height, std::vector<FramebufferAttachment> colorAttachments,
+                             const FramebufferDepth depth)
+        : _attachments(std::move(colorAttachments)), _depth(depth), _width(width), _height(height)
+    {
+        glGenFramebuffers(1, &_framebufferId);
+        createAttachments();
+    }
+
+    Framebuffer::~Framebuffer()
+    {
+        deleteAttachments();
+
+        GLStateCache::onFramebufferDeleted(_framebufferId);
+        glDeleteFramebuffers(1, &_framebufferId);
+    }
+
+    void Framebuffer::resize(const int width, const int height)
+    {
+        if (width == _width && height == _height)
+        {
+            return;
+        }
+
+        _width = width;
+        _height = height;
+
+        deleteAttachments();
+        createAttachments();
+    }
+
+    void Framebuffer::bind() const
+    {
+        GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, _framebufferId);
+    }
+
+    unsigned int Framebuffer::getId() const
+    {
+        return _framebufferId;
+    }
+
+    unsigned int Framebuffer::getColorTexture(const size_t index) const
+    {
+        return _colorTextures[index];
+    }
+
+    unsigned int Framebuffer::getDepthTexture() const
+    {
+        return _depthTexture;
+    }
+
+    int Framebuffer::getWidth() const
+    {
+        return _width;
+    }
+
+    int Framebuffer::getHeight() const
+    {
+        return _height;
+    }
+
+    bool Framebuffer::isComplete() const
+    {
+        return _isComplete;
+    }
+
+    void Framebuffer::createAttachments()
+    {
+        bind();
+
+        std::vector<GLenum> drawBuffers;
+        _colorTextures.resize(_attachments.size());
+        glGenTextures(static_cast<GLsizei>(_colorTextures.size()), _colorTextures.data());
+
+        for (size_t i = 0; i < _attachments.size(); i++)
+        {
+            const FramebufferAttachment& attachment = _attachments[i];
+
+            GLStateCache::bindTexture(GL_TEXTURE_2D, _colorTextures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, attachment.internalFormat, _width, _height, 0, attachment.format, attachment.type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, attachment.filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, attachment.filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            const auto colorAttachment = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, colorAttachment, GL_TEXTURE_2D, _colorTextures[i], 0);
+            drawBuffers.push_back(colorAttachment);
+        }
+
+        if (_depth == FramebufferDepth::Texture)
+        {
+            glGenTextures(1, &_depthTexture);
+            GLStateCache::bindTexture(GL_TEXTURE_2D, _depthTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, _width, _height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, _depthTexture, 0);
+        }
+        else if (_depth == FramebufferDepth::Renderbuffer)
+        {
+            glGenRenderbuffers(1, &_depthRenderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer);
+        }
+
+        GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
+
+        if (drawBuffers.empty())
+        {
+            glDrawBuffer(GL_NONE);
+        }
+        else
+        {
+            glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+        }
+
+        _isComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+        if (!_isComplete)
+        {
+            std::cerr << "Framebuffer with " << _attachments.size() << " color attachments at " << _width << "x" << _height
+                << " is incomplete.\n";
+        }
+    }
+
+    void Framebuffer::deleteAttachments()
+    {
+        for (const unsigned int texture : _colorTextures)
+        {
+            GLStateCache::onTextureDeleted(texture);
+        }
+
+        glDeleteTextures(static_cast<GLsizei>(_colorTextures.size()), _colorTextures.data());
+        _colorTextures.clear();
+
+        if (_depthTexture != 0)
+        {
+            GLStateCache::onTextureDeleted(_depthTexture);
+            glDeleteTextures(1, &_depthTexture);
+            _depthTexture = 0;
+        }
+
+        if (_depthRenderbuffer != 0)
+        {
+            glDeleteRenderbuffers(1, &_depthRenderbuffer);
+            _depthRenderbuffer = 0;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+﻿#pragma once
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+namespace LearnOpenGL::Graphics
+{
+    // format of one color attachment, as passed to glTexImage2D
+    struct FramebufferAttachment
+    {
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+        GLint filter = GL_LINEAR;
+    };
+
+    enum class FramebufferDepth
+    {
+        None,
+        // depth and stencil that are only ever tested against
+        Renderbuffer,
+        // depth and stencil that can also be sampled, as GL_DEPTH24_STENCIL8
+        Texture
+    };
+
+    // A framebuffer object with texture color attachments, drawing to all of them at once.
+    class Framebuffer
+    {
+    public:
+        Framebuffer(int width, int height, std::vector<FramebufferAttachment> colorAttachments,
+                    FramebufferDepth depth = FramebufferDepth::Renderbuffer);
+        Framebuffer(const Framebuffer&) = delete;
+        Framebuffer(Framebuffer&&) = delete;
+
+        Framebuffer& operator=(const Framebuffer&) = delete;
+        Framebuffer& operator=(Framebuffer&&) = delete;
+
+        ~Framebuffer();
+
+        // Reallocates every attachment at the new size, dropping their contents. Does nothing if the size is unchanged.
+        void resize(int width, int height);
+        void bind() const;
+
+        [[nodiscard]] unsigned int getId() const;
+        [[nodiscard]] unsigned int getColorTexture(size_t index) const;
+        // 0 unless created with FramebufferDepth::Texture
+        [[nodiscard]] unsigned int getDepthTexture() const;
+        [[nodiscard]] int getWidth() const;
+        [[nodiscard]] int getHeight() const;
+        [[nodiscard]] bool isComplete() const;
+
+    private:
+        unsigned int _framebufferId{};
+        std::vector<FramebufferAttachment> _attachments;
+        std::vector<unsigned int> _colorTextures;
+        FramebufferDepth _depth;
+        unsigned int _depthTexture{};
+        unsigned int _depthRenderbuffer{};
+        int _width;
+        int _height;
+        bool _isComplete = false;
+
+        void createAttachments();
+        void deleteAttachments();
+    };
+}
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,133 @@
+﻿#include "GLExtensions.h"
+
+#include <iostream>
+
+namespace LearnOpenGL::Graphics
+{
+    void GLExtensions::load(const GLADloadproc loader)
+    {
+        _extensions.clear();
+
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        for (GLint i = 0; i < extensionCount; i++)
+        {
+            _extensions.emplace(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))));
+        }
+
+        _multiDrawElementsIndirect = nullptr;
+
+        if (isVersionAtLeast(4, 3)
+            || (hasExtension("GL_ARB_multi_draw_indirect") && (isVersionAtLeast(4, 2) || hasExtension("GL_ARB_base_instance"))))
+        {
+            _multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(loader("glMultiDrawElementsIndirect"));
+        }
+
+        _bufferStorage = nullptr;
+
+        if (isVersionAtLeast(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+        {
+            _bufferStorage = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+        }
+
+        _getProgramBinary = nullptr;
+        _programBinary = nullptr;
+        _programParameteri = nullptr;
+
+        if (isVersionAtLeast(4, 1) || hasExtension("GL_ARB_get_program_binary"))
+        {
+            // drivers may expose the functions without supporting a single format
+            GLint formatCount = 0;
+            glGetIntegerv(NumProgramBinaryFormats, &formatCount);
+
+            if (formatCount > 0)
+            {
+                _getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(loader("glGetProgramBinary"));
+                _programBinary = reinterpret_cast<ProgramBinaryProc>(loader("glProgramBinary"));
+                _programParameteri = reinterpret_cast<ProgramParameteriProc>(loader("glProgramParameteri"));
+            }
+        }
+
+        _maxShaderCompilerThreads = nullptr;
+
+        if (hasExtension("GL_KHR_parallel_shader_compile"))
+        {
+            _maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(loader("glMaxShaderCompilerThreadsKHR"));
+        }
+        else if (hasExtension("GL_ARB_parallel_shader_compile"))
+        {
+            _maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(loader("glMaxShaderCompilerThreadsARB"));
+        }
+
+        std::cerr << "GL " << GLVersion.major << '.' << GLVersion.minor << ", " << extensionCount << " extensions. Multi-draw indirect: "
+            << (supportsMultiDrawIndirect() ? "yes" : "no") << ", buffer storage: " << (supportsBufferStorage() ? "yes" : "no")
+            << ", program binaries: " << (supportsProgramBinary() ? "yes" : "no")
+            << ", parallel shader compile: " << (supportsParallelShaderCompile() ? "yes" : "no") << ".\n";
+    }
+
+    bool GLExtensions::isVersionAtLeast(const int major, const int minor)
+    {
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+
+    bool GLExtensions::hasExtension(const std::string& name)
+    {
+        return _extensions.contains(name);
+    }
+
+    bool GLExtensions::supportsMultiDrawIndirect()
+    {
+        return _multiDrawElementsIndirect != nullptr;
+    }
+
+    void GLExtensions::multiDrawElementsIndirect(const GLenum mode, const GLenum type, const void* indirect, const GLsizei drawCount,
+                                                 const GLsizei stride)
+    {
+        _multiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+
+    bool GLExtensions::supportsBufferStorage()
+    {
+        return _bufferStorage != nullptr;
+    }
+
+    void GLExtensions::bufferStorage(const GLenum target, const GLsizeiptr size, const void* data, const GLbitfield flags)
+    {
+        _bufferStorage(target, size, data, flags);
+    }
+
+    bool GLExtensions::supportsProgramBinary()
+    {
+        return _getProgramBinary != nullptr && _programBinary != nullptr && _programParameteri != nullptr;
+    }
+
+    void GLExtensions::getProgramBinary(const GLuint program, const GLsizei bufferSize, GLsizei* length, GLenum* binaryFormat,
+                                        void* binary)
+    {
+        _getProgramBinary(program, bufferSize, length, binaryFormat, binary);
+    }
+
+    void GLExtensions::programBinary(const GLuint program, const GLenum binaryFormat, const void* binary, const GLsizei length)
+    {
+        _programBinary(program, binaryFormat, binary, length);
+    }
+
+    void GLExtensions::programParameteri(const GLuint program, const GLenum name, const GLint value)
+    {
+        _programParameteri(program, name, value);
+    }
+
+    bool GLExtensions::supportsParallelShaderCompile()
+    {
+        return _maxShaderCompilerThreads != nullptr;
+    }
+
+    void GLExtensions::useAllShaderCompilerThreads()
+    {
+        if (_maxShaderCompilerThreads)
+        {
+            _maxShaderCompilerThreads(0xFFFFFFFF);
+        }
+    }
+}
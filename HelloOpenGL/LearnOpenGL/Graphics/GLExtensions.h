@@ -0,0 +1,79 @@
+﻿#pragma once
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <string>
+#include <unordered_set>
+#include <glad/glad.h>
+
+namespace LearnOpenGL::Graphics
+{
+    // Enums and structs from past GL 3.3, which the glad loader stops at.
+    constexpr GLenum DrawIndirectBufferTarget = 0x8F3F;
+    constexpr GLbitfield MapPersistentBit = 0x0040;
+    constexpr GLbitfield MapCoherentBit = 0x0080;
+    constexpr GLenum ProgramBinaryRetrievableHint = 0x8257;
+    constexpr GLenum ProgramBinaryLength = 0x8741;
+    constexpr GLenum NumProgramBinaryFormats = 0x87FE;
+    constexpr GLenum CompletionStatus = 0x91B1;
+
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Loads the functions this project uses from newer GL versions or extensions, when the context has them.
+    // Call once after gladLoadGLLoader; every query answers false until then.
+    class GLExtensions
+    {
+    public:
+        static void load(GLADloadproc loader);
+
+        [[nodiscard]] static bool isVersionAtLeast(int major, int minor);
+        [[nodiscard]] static bool hasExtension(const std::string& name);
+
+        // glMultiDrawElementsIndirect with baseInstance honored (GL 4.3, or ARB_multi_draw_indirect + ARB_base_instance)
+        [[nodiscard]] static bool supportsMultiDrawIndirect();
+        static void multiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+
+        // glBufferStorage, for immutable buffers that can stay mapped (GL 4.4 or ARB_buffer_storage)
+        [[nodiscard]] static bool supportsBufferStorage();
+        static void bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+        // glGetProgramBinary and glProgramBinary, with at least one binary format to use them with
+        // (GL 4.1 or ARB_get_program_binary)
+        [[nodiscard]] static bool supportsProgramBinary();
+        static void getProgramBinary(GLuint program, GLsizei bufferSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+        static void programBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+        static void programParameteri(GLuint program, GLenum name, GLint value);
+
+        // GL_COMPLETION_STATUS can be queried without waiting on the compiler (KHR_ or ARB_parallel_shader_compile)
+        [[nodiscard]] static bool supportsParallelShaderCompile();
+        // Lets the driver pick how many threads compile in the background.
+        static void useAllShaderCompilerThreads();
+
+    private:
+        typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount,
+                                                               GLsizei stride);
+        typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+        typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufferSize, GLsizei* length, GLenum* binaryFormat,
+                                                      void* binary);
+        typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+        typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum name, GLint value);
+        typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+        inline static std::unordered_set<std::string> _extensions;
+        inline static MultiDrawElementsIndirectProc _multiDrawElementsIndirect = nullptr;
+        inline static BufferStorageProc _bufferStorage = nullptr;
+        inline static GetProgramBinaryProc _getProgramBinary = nullptr;
+        inline static ProgramBinaryProc _programBinary = nullptr;
+        inline static ProgramParameteriProc _programParameteri = nullptr;
+        inline static MaxShaderCompilerThreadsProc _maxShaderCompilerThreads = nullptr;
+    };
+}
+
+#endif // GL_EXTENSIONS_H
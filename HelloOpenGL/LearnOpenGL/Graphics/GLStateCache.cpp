@@ -0,0 +1,249 @@
+﻿#include "GLStateCache.h"
+
+namespace LearnOpenGL::Graphics
+{
+    size_t GLStateCacheStats::getTotalIssued() const
+    {
+        return programs.issued + vertexArrays.issued + textures.issued + framebuffers.issued + capabilities.issued;
+    }
+
+    size_t GLStateCacheStats::getTotalSkipped() const
+    {
+        return programs.skipped + vertexArrays.skipped + textures.skipped + framebuffers.skipped + capabilities.skipped;
+    }
+
+    void GLStateCache::useProgram(const GLuint program)
+    {
+        if (update(_program, program, _currentFrame.programs))
+        {
+            glUseProgram(program);
+        }
+    }
+
+    void GLStateCache::bindVertexArray(const GLuint vertexArray)
+    {
+        if (update(_vertexArray, vertexArray, _currentFrame.vertexArrays))
+        {
+            glBindVertexArray(vertexArray);
+        }
+    }
+
+    void GLStateCache::activeTexture(const GLenum textureUnit)
+    {
+        // not counted on its own; it is only ever issued to make a texture bind possible
+        if (_activeTexture != textureUnit)
+        {
+            _activeTexture = textureUnit;
+            glActiveTexture(textureUnit);
+        }
+    }
+
+    void GLStateCache::bindTexture(const GLenum target, const GLuint texture)
+    {
+        initialize();
+
+        const size_t targetIndex = getTextureTargetIndex(target);
+        const GLuint unit = _activeTexture == Unknown ? MaxTextureUnits : _activeTexture - GL_TEXTURE0;
+
+        if (targetIndex == TextureTargetCount || unit >= MaxTextureUnits)
+        {
+            _currentFrame.textures.issued++;
+            glBindTexture(target, texture);
+
+            return;
+        }
+
+        if (update(_textures[unit][targetIndex], texture, _currentFrame.textures))
+        {
+            glBindTexture(target, texture);
+        }
+    }
+
+    void GLStateCache::bindTexture(const GLenum textureUnit, const GLenum target, const GLuint texture)
+    {
+        initialize();
+
+        const GLuint unit = textureUnit - GL_TEXTURE0;
+        const size_t targetIndex = getTextureTargetIndex(target);
+
+        // skip switching units at all when the unit already has the texture bound
+        if (unit < MaxTextureUnits && targetIndex != TextureTargetCount && _textures[unit][targetIndex] == texture)
+        {
+            _currentFrame.textures.skipped++;
+            return;
+        }
+
+        activeTexture(textureUnit);
+        bindTexture(target, texture);
+    }
+
+    void GLStateCache::bindFramebuffer(const GLenum target, const GLuint framebuffer)
+    {
+        if (target == GL_FRAMEBUFFER)
+        {
+            if (_drawFramebuffer == framebuffer && _readFramebuffer == framebuffer)
+            {
+                _currentFrame.framebuffers.skipped++;
+                return;
+            }
+
+            _drawFramebuffer = framebuffer;
+            _readFramebuffer = framebuffer;
+            _currentFrame.framebuffers.issued++;
+            glBindFramebuffer(target, framebuffer);
+
+            return;
+        }
+
+        GLuint& current = target == GL_READ_FRAMEBUFFER ? _readFramebuffer : _drawFramebuffer;
+
+        if (update(current, framebuffer, _currentFrame.framebuffers))
+        {
+            glBindFramebuffer(target, framebuffer);
+        }
+    }
+
+    void GLStateCache::enable(const GLenum capability)
+    {
+        setCapability(capability, true);
+    }
+
+    void GLStateCache::disable(const GLenum capability)
+    {
+        setCapability(capability, false);
+    }
+
+    void GLStateCache::onProgramDeleted(const GLuint program)
+    {
+        if (_program == program)
+        {
+            _program = Unknown;
+        }
+    }
+
+    void GLStateCache::onVertexArrayDeleted(const GLuint vertexArray)
+    {
+        if (_vertexArray == vertexArray)
+        {
+            _vertexArray = Unknown;
+        }
+    }
+
+    void GLStateCache::onTextureDeleted(const GLuint texture)
+    {
+        for (auto& unit : _textures)
+        {
+            for (GLuint& boundTexture : unit)
+            {
+                if (boundTexture == texture)
+                {
+                    boundTexture = Unknown;
+                }
+            }
+        }
+    }
+
+    void GLStateCache::onFramebufferDeleted(const GLuint framebuffer)
+    {
+        if (_drawFramebuffer == framebuffer)
+        {
+            _drawFramebuffer = Unknown;
+        }
+
+        if (_readFramebuffer == framebuffer)
+        {
+            _readFramebuffer = Unknown;
+        }
+    }
+
+    void GLStateCache::invalidate()
+    {
+        _program = Unknown;
+        _vertexArray = Unknown;
+        _activeTexture = Unknown;
+        _drawFramebuffer = Unknown;
+        _readFramebuffer = Unknown;
+        _capabilities.clear();
+
+        for (auto& unit : _textures)
+        {
+            unit.fill(Unknown);
+        }
+
+        _initialized = true;
+    }
+
+    void GLStateCache::beginFrame()
+    {
+        _lastFrame = _currentFrame;
+        _currentFrame = {};
+    }
+
+    GLStateCacheStats GLStateCache::getFrameStats()
+    {
+        return _lastFrame;
+    }
+
+    void GLStateCache::initialize()
+    {
+        // zero-initialized texture slots would claim texture 0 is bound everywhere, so start from "unknown" instead
+        if (!_initialized)
+        {
+            invalidate();
+        }
+    }
+
+    void GLStateCache::setCapability(const GLenum capability, const bool enabled)
+    {
+        const auto current = _capabilities.find(capability);
+
+        if (current != _capabilities.end() && current->second == enabled)
+        {
+            _currentFrame.capabilities.skipped++;
+            return;
+        }
+
+        _capabilities[capability] = enabled;
+        _currentFrame.capabilities.issued++;
+
+        if (enabled)
+        {
+            glEnable(capability);
+        }
+        else
+        {
+            glDisable(capability);
+        }
+    }
+
+    size_t GLStateCache::getTextureTargetIndex(const GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D:
+            return Texture2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return Texture2DArray;
+        case GL_TEXTURE_BUFFER:
+            return TextureBuffer;
+        case GL_TEXTURE_CUBE_MAP:
+            return TextureCubeMap;
+        default:
+            return TextureTargetCount;
+        }
+    }
+
+    bool GLStateCache::update(GLuint& current, const GLuint value, GLStateCounters& counters)
+    {
+        if (current == value)
+        {
+            counters.skipped++;
+            return false;
+        }
+
+        current = value;
+        counters.issued++;
+
+        return true;
+    }
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <glad/glad.h>
+
+namespace LearnOpenGL::Graphics
+{
+    struct GLStateCounters
+    {
+        size_t issued;
+        size_t skipped;
+    };
+
+    struct GLStateCacheStats
+    {
+        GLStateCounters programs;
+        GLStateCounters vertexArrays;
+        GLStateCounters textures;
+        GLStateCounters framebuffers;
+        GLStateCounters capabilities;
+
+        [[nodiscard]] size_t getTotalIssued() const;
+        [[nodiscard]] size_t getTotalSkipped() const;
+    };
+
+    // Shadows the bindings the renderer changes most often and drops calls that would not change anything.
+    // Anything binding these objects directly through GL has to go through here instead, or call invalidate() afterwards.
+    // Only use from the thread owning the GL context.
+    class GLStateCache
+    {
+    public:
+        static constexpr GLuint MaxTextureUnits = 32;
+
+        static void useProgram(GLuint program);
+        static void bindVertexArray(GLuint vertexArray);
+
+        // activeTexture takes GL_TEXTURE0 + n, as glActiveTexture does.
+        static void activeTexture(GLenum textureUnit);
+        static void bindTexture(GLenum target, GLuint texture);
+        static void bindTexture(GLenum textureUnit, GLenum target, GLuint texture);
+
+        static void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+        static void enable(GLenum capability);
+        static void disable(GLenum capability);
+
+        // GL drops bindings to deleted objects, and their names may be handed out again.
+        static void onProgramDeleted(GLuint program);
+        static void onVertexArrayDeleted(GLuint vertexArray);
+        static void onTextureDeleted(GLuint texture);
+        static void onFramebufferDeleted(GLuint framebuffer);
+
+        // Forget everything, for when code outside our control (e.g. ImGui's renderer) has touched GL state.
+        static void invalidate();
+
+        // Starts counting a new frame; getFrameStats() keeps returning the previous, complete frame.
+        static void beginFrame();
+        [[nodiscard]] static GLStateCacheStats getFrameStats();
+
+    private:
+        static constexpr GLuint Unknown = 0xFFFFFFFF;
+
+        enum TextureTarget : size_t
+        {
+            Texture2D,
+            Texture2DArray,
+            TextureBuffer,
+            TextureCubeMap,
+            TextureTargetCount,
+        };
+
+        inline static GLuint _program = Unknown;
+        inline static GLuint _vertexArray = Unknown;
+        inline static GLenum _activeTexture = Unknown;
+        inline static std::array<std::array<GLuint, TextureTargetCount>, MaxTextureUnits> _textures{};
+        inline static GLuint _drawFramebuffer = Unknown;
+        inline static GLuint _readFramebuffer = Unknown;
+        inline static std::unordered_map<GLenum, bool> _capabilities{};
+
+        inline static GLStateCacheStats _currentFrame{};
+        inline static GLStateCacheStats _lastFrame{};
+        inline static bool _initialized = false;
+
+        static void initialize();
+        static void setCapability(GLenum capability, bool enabled);
+        static size_t getTextureTargetIndex(GLenum target);
+        static bool update(GLuint& current, GLuint value, GLStateCounters& counters);
+    };
+}
+
+#endif // GL_STATE_CACHE_H
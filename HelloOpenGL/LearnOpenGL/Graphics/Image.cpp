@@ -1,2 +1,65 @@
 ﻿#define STB_IMAGE_IMPLEMENTATION
 #include "Image.h"
+
+#include "../Utilities/Hash.h"
+#include "../Utilities/MappedFile.h"
+
+namespace LearnOpenGL::Graphics
+{
+    bool Image::isValid() const
+    {
+        return _data != nullptr;
+    }
+
+    int Image::getWidth() const
+    {
+        return _width;
+    }
+
+    int Image::getHeight() const
+    {
+        return _height;
+    }
+
+    int Image::getChannels() const
+    {
+        return _channels;
+    }
+
+    const unsigned char* Image::getData() const
+    {
+        return _data.get();
+    }
+
+    size_t Image::getByteSize() const
+    {
+        return static_cast<size_t>(_width) * static_cast<size_t>(_height) * static_cast<size_t>(_channels);
+    }
+
+    uint64_t Image::getContentHash() const
+    {
+        return _contentHash;
+    }
+
+    Image Image::loadFromFile(const std::string& imagePath)
+    {
+        Image image;
+        const Utilities::MappedFile file{ imagePath };
+
+        if (!file.isOpen())
+        {
+            return image;
+        }
+
+        image._contentHash = Utilities::hashBytes(file.getData(), file.getSize());
+        image._data.reset(stbi_load_from_memory(file.getData(), static_cast<int>(file.getSize()), &image._width, &image._height,
+                                                &image._channels, 0));
+
+        return image;
+    }
+
+    void Image::ImageDeleter::operator()(unsigned char* data) const
+    {
+        stbi_image_free(data);
+    }
+}
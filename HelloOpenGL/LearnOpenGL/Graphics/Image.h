@@ -2,6 +2,45 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <stb/stb_image.h>
 
+namespace LearnOpenGL::Graphics
+{
+    // Decoded pixels kept on the CPU. Decoding touches no GL state, so images can be loaded on worker threads
+    // and handed to the context thread for upload.
+    class Image
+    {
+    public:
+        Image() = default;
+
+        [[nodiscard]] bool isValid() const;
+        [[nodiscard]] int getWidth() const;
+        [[nodiscard]] int getHeight() const;
+        [[nodiscard]] int getChannels() const;
+        [[nodiscard]] const unsigned char* getData() const;
+        [[nodiscard]] size_t getByteSize() const;
+
+        // Hash of the encoded file, so identical files stored under different names can be told apart without comparing pixels.
+        [[nodiscard]] uint64_t getContentHash() const;
+
+        static Image loadFromFile(const std::string& imagePath);
+
+    private:
+        struct ImageDeleter
+        {
+            void operator()(unsigned char* data) const;
+        };
+
+        int _width{};
+        int _height{};
+        int _channels{};
+        uint64_t _contentHash{};
+        std::unique_ptr<unsigned char, ImageDeleter> _data;
+    };
+}
+
 #endif // IMAGE_H
@@ -0,0 +1,330 @@
+﻿#include "LightClusters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+
+namespace LearnOpenGL::Graphics
+{
+    LightClusters::LightClusters()
+        : _uniformBuffer(ClusterUniformsBlockName, sizeof(ClusterUniforms), true),
+          _clusterRanges(ClusterCount),
+          _clusterCursors(ClusterCount)
+    {
+        glGenBuffers(BufferCount, _buffers.data());
+        glGenTextures(BufferCount, _textures.data());
+
+        constexpr GLenum formats[BufferCount] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+
+        for (size_t i = 0; i < BufferCount; i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, _buffers[i]);
+            // texture buffers without storage are incomplete, so every buffer starts out with one zeroed element
+            glBufferData(GL_TEXTURE_BUFFER, sizeof(PointLightData), nullptr, GL_STREAM_DRAW);
+
+            GLStateCache::bindTexture(GL_TEXTURE0 + LightTextureUnit + static_cast<unsigned int>(i), GL_TEXTURE_BUFFER, _textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], _buffers[i]);
+        }
+    }
+
+    LightClusters::~LightClusters()
+    {
+        for (const unsigned int texture : _textures)
+        {
+            GLStateCache::onTextureDeleted(texture);
+        }
+
+        glDeleteTextures(BufferCount, _textures.data());
+        glDeleteBuffers(BufferCount, _buffers.data());
+    }
+
+    void LightClusters::update(const std::span<const PointLightData> lights, const Camera& camera)
+    {
+        const auto assignStart = std::chrono::steady_clock::now();
+
+        _lights = lights.first(std::min(lights.size(), MaxLights));
+        _view = camera.calculateView();
+        _nearClip = camera.getNearClip();
+        _farClip = camera.getFarClip();
+
+        updatePlanes(camera.getFov(), camera.getAspectRatio());
+        updateUniforms(camera);
+
+        _lightBounds.resize(_lights.size());
+        parallelFor(_lights.size(), 64, [this](const size_t first, const size_t last) { computeBounds(first, last); });
+
+        parallelFor(GridDepth, 1, [this](const size_t first, const size_t last)
+        {
+            countSlices(static_cast<unsigned int>(first), static_cast<unsigned int>(last));
+        });
+
+        // ranges are laid out in cluster order, so every slice's indices end up in one contiguous block
+        uint32_t offset = 0;
+        _stats = { _lights.size(), 0, 0, 0, 0, 0.0 };
+
+        for (size_t i = 0; i < ClusterCount; i++)
+        {
+            _clusterRanges[i].x = offset;
+            _clusterCursors[i] = offset;
+            offset += _clusterRanges[i].y;
+
+            _stats.litClusters += _clusterRanges[i].y > 0 ? 1 : 0;
+            _stats.maxClusterLights = std::max<size_t>(_stats.maxClusterLights, _clusterRanges[i].y);
+        }
+
+        _lightIndices.resize(std::max<size_t>(offset, 1));
+        parallelFor(GridDepth, 1, [this](const size_t first, const size_t last)
+        {
+            fillSlices(static_cast<unsigned int>(first), static_cast<unsigned int>(last));
+        });
+
+        _stats.visibleLights = static_cast<size_t>(std::ranges::count_if(_lightBounds, [](const LightBounds& bounds) { return bounds.isVisible; }));
+        _stats.lightReferences = offset;
+        _stats.assignMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - assignStart).count();
+
+        upload();
+    }
+
+    void LightClusters::bind() const
+    {
+        for (size_t i = 0; i < BufferCount; i++)
+        {
+            GLStateCache::bindTexture(GL_TEXTURE0 + LightTextureUnit + static_cast<unsigned int>(i), GL_TEXTURE_BUFFER, _textures[i]);
+        }
+    }
+
+    const LightClusterStats& LightClusters::getStats() const
+    {
+        return _stats;
+    }
+
+    void LightClusters::setupSamplerUnits(const Shader& shader)
+    {
+        shader.use();
+        shader.setInt("clusterLights", static_cast<int>(LightTextureUnit));
+        shader.setInt("clusterRanges", static_cast<int>(RangeTextureUnit));
+        shader.setInt("clusterLightIndices", static_cast<int>(IndexTextureUnit));
+    }
+
+    void LightClusters::updatePlanes(const float fov, const float aspectRatio)
+    {
+        if (fov == _planeFov && aspectRatio == _planeAspectRatio)
+        {
+            return;
+        }
+
+        _planeFov = fov;
+        _planeAspectRatio = aspectRatio;
+
+        const float tanHalfFovY = std::tan(glm::radians(fov) * 0.5f);
+        const float tanHalfFovX = tanHalfFovY * aspectRatio;
+
+        // the plane through the eye and the tile edge at ndc x has the normal (1, 0, x * tanHalfFovX)
+        for (unsigned int i = 0; i <= GridWidth; i++)
+        {
+            const glm::vec2 normal = glm::normalize(glm::vec2(1.0f, (-1.0f + 2.0f * static_cast<float>(i) / GridWidth) * tanHalfFovX));
+            _columnPlaneX[i] = normal.x;
+            _columnPlaneZ[i] = normal.y;
+        }
+
+        for (unsigned int i = 0; i <= GridHeight; i++)
+        {
+            const glm::vec2 normal = glm::normalize(glm::vec2(1.0f, (-1.0f + 2.0f * static_cast<float>(i) / GridHeight) * tanHalfFovY));
+            _rowPlaneY[i] = normal.x;
+            _rowPlaneZ[i] = normal.y;
+        }
+    }
+
+    void LightClusters::updateUniforms(const Camera& camera)
+    {
+        const float sliceNear = std::max(_nearClip, MinSliceDepth);
+        const float depthRange = std::log(std::max(_farClip, sliceNear * 2.0f) / sliceNear);
+
+        _uniforms.gridSize = glm::uvec4(GridWidth, GridHeight, GridDepth, 0u);
+        _uniforms.tileScale = glm::vec2(static_cast<float>(GridWidth) / static_cast<float>(std::max(camera.getViewportWidth(), 1)),
+                                        static_cast<float>(GridHeight) / static_cast<float>(std::max(camera.getViewportHeight(), 1)));
+        _uniforms.depthScale = static_cast<float>(GridDepth) / depthRange;
+        _uniforms.depthBias = -static_cast<float>(GridDepth) * std::log(sliceNear) / depthRange;
+
+        _uniformBuffer.setData(_uniforms);
+    }
+
+    uint8_t LightClusters::getSlice(const float depth) const
+    {
+        // matches getLightCluster in clustered_lights.glsl
+        const float slice = std::log(std::max(depth, MinSliceDepth)) * _uniforms.depthScale + _uniforms.depthBias;
+        return static_cast<uint8_t>(std::clamp(slice, 0.0f, static_cast<float>(GridDepth - 1)));
+    }
+
+    void LightClusters::computeBounds(const size_t firstLight, const size_t lastLight)
+    {
+        std::array<float, GridWidth + 1> columnDistances{};
+        std::array<float, GridHeight + 1> rowDistances{};
+
+        for (size_t i = firstLight; i < lastLight; i++)
+        {
+            const glm::vec3 center = glm::vec3(_view * glm::vec4(_lights[i].position, 1.0f));
+            const float radius = _lights[i].radius;
+            const float depth = -center.z;
+
+            LightBounds& bounds = _lightBounds[i];
+            bounds.isVisible = false;
+
+            if (radius <= 0.0f || depth + radius < _nearClip || depth - radius > _farClip)
+            {
+                continue;
+            }
+
+            // distances fall from the leftmost plane to the rightmost, so counting planes the sphere lies entirely
+            // right of (or reaches right of) gives the first and last tile without branching
+            for (unsigned int p = 0; p <= GridWidth; p++)
+            {
+                columnDistances[p] = _columnPlaneX[p] * center.x + _columnPlaneZ[p] * center.z;
+            }
+
+            for (unsigned int p = 0; p <= GridHeight; p++)
+            {
+                rowDistances[p] = _rowPlaneY[p] * center.y + _rowPlaneZ[p] * center.z;
+            }
+
+            int minX = 0;
+            int maxX = -1;
+            int minY = 0;
+            int maxY = -1;
+
+            for (unsigned int p = 0; p < GridWidth; p++)
+            {
+                minX += columnDistances[p + 1] >= radius ? 1 : 0;
+                maxX += columnDistances[p] > -radius ? 1 : 0;
+            }
+
+            for (unsigned int p = 0; p < GridHeight; p++)
+            {
+                minY += rowDistances[p + 1] >= radius ? 1 : 0;
+                maxY += rowDistances[p] > -radius ? 1 : 0;
+            }
+
+            if (minX > maxX || minY > maxY)
+            {
+                continue;
+            }
+
+            bounds.minX = static_cast<uint8_t>(minX);
+            bounds.maxX = static_cast<uint8_t>(maxX);
+            bounds.minY = static_cast<uint8_t>(minY);
+            bounds.maxY = static_cast<uint8_t>(maxY);
+            bounds.minZ = getSlice(depth - radius);
+            bounds.maxZ = getSlice(depth + radius);
+            bounds.isVisible = true;
+        }
+    }
+
+    void LightClusters::countSlices(const unsigned int firstSlice, const unsigned int lastSlice)
+    {
+        const size_t firstCluster = static_cast<size_t>(firstSlice) * GridWidth * GridHeight;
+        const size_t lastCluster = static_cast<size_t>(lastSlice) * GridWidth * GridHeight;
+
+        for (size_t i = firstCluster; i < lastCluster; i++)
+        {
+            _clusterRanges[i].y = 0;
+        }
+
+        for (const LightBounds& bounds : _lightBounds)
+        {
+            if (!bounds.isVisible || bounds.maxZ < firstSlice || bounds.minZ >= lastSlice)
+            {
+                continue;
+            }
+
+            for (unsigned int z = std::max<unsigned int>(bounds.minZ, firstSlice); z <= std::min<unsigned int>(bounds.maxZ, lastSlice - 1); z++)
+            {
+                for (unsigned int y = bounds.minY; y <= bounds.maxY; y++)
+                {
+                    for (unsigned int x = bounds.minX; x <= bounds.maxX; x++)
+                    {
+                        _clusterRanges[x + GridWidth * (y + GridHeight * z)].y++;
+                    }
+                }
+            }
+        }
+    }
+
+    void LightClusters::fillSlices(const unsigned int firstSlice, const unsigned int lastSlice)
+    {
+        for (size_t i = 0; i < _lightBounds.size(); i++)
+        {
+            const LightBounds& bounds = _lightBounds[i];
+
+            if (!bounds.isVisible || bounds.maxZ < firstSlice || bounds.minZ >= lastSlice)
+            {
+                continue;
+            }
+
+            for (unsigned int z = std::max<unsigned int>(bounds.minZ, firstSlice); z <= std::min<unsigned int>(bounds.maxZ, lastSlice - 1); z++)
+            {
+                for (unsigned int y = bounds.minY; y <= bounds.maxY; y++)
+                {
+                    for (unsigned int x = bounds.minX; x <= bounds.maxX; x++)
+                    {
+                        _lightIndices[_clusterCursors[x + GridWidth * (y + GridHeight * z)]++] = static_cast<uint16_t>(i);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename Function>
+    void LightClusters::parallelFor(const size_t count, const size_t minimumRange, const Function& function)
+    {
+        const size_t rangeCount = std::clamp<size_t>(count / std::max<size_t>(minimumRange, 1), 1, _threadPool.getThreadCount() + 1);
+        const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+        std::vector<std::future<void>> workers;
+        workers.reserve(rangeCount - 1);
+
+        for (size_t first = rangeSize; first < count; first += rangeSize)
+        {
+            workers.push_back(_threadPool.submit([&function, first, last = std::min(first + rangeSize, count)] { function(first, last); }));
+        }
+
+        // the calling thread takes the first range instead of idling
+        function(0, std::min(rangeSize, count));
+
+        for (std::future<void>& worker : workers)
+        {
+            worker.get();
+        }
+    }
+
+    void LightClusters::upload()
+    {
+        // the buffers are rewritten every frame; respecifying their storage lets the driver hand out fresh memory
+        // instead of waiting for draws still reading last frame's lights
+        const auto uploadBuffer = [this](const BufferIndex buffer, const void* data, const size_t size)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, _buffers[buffer]);
+            glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), data, GL_STREAM_DRAW);
+        };
+
+        if (_lights.empty())
+        {
+            const PointLightData emptyLight{};
+            uploadBuffer(LightBuffer, &emptyLight, sizeof(emptyLight));
+        }
+        else
+        {
+            uploadBuffer(LightBuffer, _lights.data(), _lights.size_bytes());
+        }
+
+        uploadBuffer(RangeBuffer, _clusterRanges.data(), _clusterRanges.size() * sizeof(glm::uvec2));
+        uploadBuffer(IndexBuffer, _lightIndices.data(), _lightIndices.size() * sizeof(uint16_t));
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        // the span only lives as long as the caller's lights
+        _lights = {};
+    }
+}
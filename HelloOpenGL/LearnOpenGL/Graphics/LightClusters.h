@@ -0,0 +1,131 @@
+﻿#pragma once
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "Shader.h"
+#include "UniformBlocks.h"
+#include "UniformBuffer.h"
+#include "../Utilities/ThreadPool.h"
+
+namespace LearnOpenGL::Graphics
+{
+    struct LightClusterStats
+    {
+        size_t lights;
+        // lights reaching into the view frustum
+        size_t visibleLights;
+        // clusters with at least one light
+        size_t litClusters;
+        // entries in the light index list, one per light per cluster it reaches
+        size_t lightReferences;
+        size_t maxClusterLights;
+        double assignMilliseconds;
+    };
+
+    // Clustered forward lighting: sorts point lights into a grid of view-space froxels (screen tiles split into
+    // exponentially deeper slices) on the CPU, so a fragment only shades the lights reaching its cluster.
+    // Lights, per-cluster ranges and the light index list go to the GPU as texture buffers, read by
+    // clustered_lights.glsl. Only use from the thread owning the GL context.
+    class LightClusters
+    {
+    public:
+        static constexpr unsigned int GridWidth = 16;
+        static constexpr unsigned int GridHeight = 9;
+        static constexpr unsigned int GridDepth = 24;
+        static constexpr unsigned int ClusterCount = GridWidth * GridHeight * GridDepth;
+        // the first slice starts here at the latest, so a tiny near clip does not spend half the slices on the first metre
+        static constexpr float MinSliceDepth = 0.1f;
+        // light indices are 16 bit
+        static constexpr size_t MaxLights = 65535;
+
+        // kept clear of the mesh texture units and the ones Model uses
+        static constexpr unsigned int LightTextureUnit = 10;
+        static constexpr unsigned int RangeTextureUnit = 11;
+        static constexpr unsigned int IndexTextureUnit = 12;
+
+        LightClusters();
+        LightClusters(const LightClusters&) = delete;
+        LightClusters(LightClusters&&) = delete;
+
+        LightClusters& operator=(const LightClusters&) = delete;
+        LightClusters& operator=(LightClusters&&) = delete;
+
+        ~LightClusters();
+
+        // Assigns the lights, positioned in world space, to the clusters of the camera's view and uploads the result.
+        // Lights past MaxLights are dropped, and every light needs a radius.
+        void update(std::span<const PointLightData> lights, const Camera& camera);
+        // Binds the light, range and index texture buffers to their units.
+        void bind() const;
+
+        [[nodiscard]] const LightClusterStats& getStats() const;
+
+        // Points the cluster samplers at their units. Needed once per shader before its first draw.
+        static void setupSamplerUnits(const Shader& shader);
+
+    private:
+        // inclusive cluster ranges a light's bounding sphere reaches
+        struct LightBounds
+        {
+            uint8_t minX, maxX;
+            uint8_t minY, maxY;
+            uint8_t minZ, maxZ;
+            bool isVisible;
+        };
+
+        enum BufferIndex { LightBuffer, RangeBuffer, IndexBuffer, BufferCount };
+
+        UniformBuffer _uniformBuffer;
+        ClusterUniforms _uniforms{};
+        Utilities::ThreadPool _threadPool;
+
+        std::array<unsigned int, BufferCount> _buffers{};
+        std::array<unsigned int, BufferCount> _textures{};
+
+        // normals (x or y, z) of the planes through the eye between tiles, kept apart so the plane tests vectorize
+        std::array<float, GridWidth + 1> _columnPlaneX{};
+        std::array<float, GridWidth + 1> _columnPlaneZ{};
+        std::array<float, GridHeight + 1> _rowPlaneY{};
+        std::array<float, GridHeight + 1> _rowPlaneZ{};
+        float _planeFov = 0.0f;
+        float _planeAspectRatio = 0.0f;
+
+        glm::mat4 _view{ 1.0f };
+        float _nearClip = 0.0f;
+        float _farClip = 0.0f;
+
+        std::span<const PointLightData> _lights;
+        std::vector<LightBounds> _lightBounds;
+        // offset into _lightIndices and light count of every cluster
+        std::vector<glm::uvec2> _clusterRanges;
+        std::vector<uint32_t> _clusterCursors;
+        std::vector<uint16_t> _lightIndices;
+
+        LightClusterStats _stats{};
+
+        void updatePlanes(float fov, float aspectRatio);
+        void updateUniforms(const Camera& camera);
+        [[nodiscard]] uint8_t getSlice(float depth) const;
+
+        // the three passes of update(), each over a range that never overlaps another worker's
+        void computeBounds(size_t firstLight, size_t lastLight);
+        void countSlices(unsigned int firstSlice, unsigned int lastSlice);
+        void fillSlices(unsigned int firstSlice, unsigned int lastSlice);
+
+        // Splits [0, count) into one range per worker plus one for the calling thread and waits for all of them.
+        template <typename Function>
+        void parallelFor(size_t count, size_t minimumRange, const Function& function);
+
+        void upload();
+    };
+}
+
+#endif // LIGHT_CLUSTERS_H
@@ -0,0 +1,202 @@
+﻿#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+
+#include "../Model/Mesh.h"
+
+namespace LearnOpenGL::Graphics
+{
+    uint64_t RenderQueue::makeSortKey(const uint32_t shaderSlot, const uint32_t materialSlot, const uint32_t vertexArray,
+                                      const float normalizedDepth)
+    {
+        const auto depth = static_cast<uint64_t>(std::clamp(normalizedDepth, 0.0f, 1.0f) * 65535.0f);
+
+        return (static_cast<uint64_t>(shaderSlot & 0xFF) << 56)
+            | (static_cast<uint64_t>(materialSlot & 0xFFFFFF) << 32)
+            | (static_cast<uint64_t>(vertexArray & 0xFFFF) << 16)
+            | depth;
+    }
+
+    void RenderQueue::setView(const glm::vec3& viewPosition, const Math::Frustum& frustum)
+    {
+        _viewPosition = viewPosition;
+        _frustum = frustum;
+    }
+
+    void RenderQueue::setCullingEnabled(const bool enabled)
+    {
+        _cullingEnabled = enabled;
+    }
+
+    void RenderQueue::submit(const Shader& shader, const Model::Mesh& mesh, const glm::mat4& transform,
+                             const glm::mat3& normalMatrix)
+    {
+        const Math::AABB worldBounds = mesh.getBounds().transformed(transform);
+
+        // the sphere test is cheaper and rejects most meshes on its own; the box catches long, thin ones
+        if (_cullingEnabled
+            && (!_frustum.intersects(mesh.getBoundingSphere().transformed(transform)) || !_frustum.intersects(worldBounds)))
+        {
+            _culled++;
+            return;
+        }
+
+        const float viewDistance = glm::distance(_viewPosition, worldBounds.getCenter());
+        const uint32_t shaderSlot = getShaderSlot(shader.getId());
+        const uint32_t materialSlot = getMaterialSlot(mesh.getMaterialKey());
+
+        // front to back inside each state group, so early depth testing rejects as much as possible
+        const uint64_t key = makeSortKey(shaderSlot, materialSlot, mesh.getVertexArray(), viewDistance / MaxSortDistance);
+
+        _sortEntries.push_back({ key, static_cast<uint32_t>(_items.size()) });
+        _items.push_back({ &shader, &mesh, transform, normalMatrix, materialSlot });
+    }
+
+    void RenderQueue::flush()
+    {
+        _stats.drawItems = _items.size();
+        _stats.culled = _culled;
+        _culled = 0;
+        _stats.submissionOrder = countStateChanges();
+
+        radixSort();
+
+        _stats.sorted = countStateChanges();
+
+        const Shader* currentShader = nullptr;
+        UniformHandle modelUniform;
+        UniformHandle normalMatrixUniform;
+        uint32_t currentMaterial = UINT32_MAX;
+        const glm::mat4* currentTransform = nullptr;
+
+        for (const SortEntry& entry : _sortEntries)
+        {
+            const DrawItem& item = _items[entry.item];
+
+            if (item.shader != currentShader)
+            {
+                currentShader = item.shader;
+                currentShader->use();
+                modelUniform = currentShader->getUniform("model");
+                normalMatrixUniform = currentShader->getUniform("normalMatrix");
+
+                // material and model uniforms belong to the program, so they have to be set again for this one
+                currentMaterial = UINT32_MAX;
+                currentTransform = nullptr;
+            }
+
+            if (item.materialSlot != currentMaterial)
+            {
+                currentMaterial = item.materialSlot;
+                item.mesh->bindMaterial(*currentShader);
+            }
+
+            if (!currentTransform || *currentTransform != item.transform)
+            {
+                currentTransform = &item.transform;
+                currentShader->setMat4(modelUniform, item.transform);
+                currentShader->setMat3(normalMatrixUniform, item.normalMatrix);
+            }
+
+            item.mesh->drawGeometry(*currentShader);
+        }
+
+        _items.clear();
+        _sortEntries.clear();
+    }
+
+    RenderQueueStats RenderQueue::getStats() const
+    {
+        return _stats;
+    }
+
+    uint32_t RenderQueue::getShaderSlot(const unsigned int shaderId)
+    {
+        return _shaderSlots.try_emplace(shaderId, static_cast<uint32_t>(_shaderSlots.size())).first->second;
+    }
+
+    uint32_t RenderQueue::getMaterialSlot(const uint64_t materialKey)
+    {
+        return _materialSlots.try_emplace(materialKey, static_cast<uint32_t>(_materialSlots.size())).first->second;
+    }
+
+    void RenderQueue::radixSort()
+    {
+        const size_t count = _sortEntries.size();
+
+        if (count < 2)
+        {
+            return;
+        }
+
+        _sortScratch.resize(count);
+
+        // least significant byte first; each pass is stable, so earlier passes decide ties in later ones
+        for (unsigned int shift = 0; shift < 64; shift += 8)
+        {
+            std::array<size_t, 256> offsets{};
+
+            for (const SortEntry& entry : _sortEntries)
+            {
+                offsets[(entry.key >> shift) & 0xFF]++;
+            }
+
+            // a byte shared by every key cannot change the order
+            if (offsets[(_sortEntries.front().key >> shift) & 0xFF] == count)
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (size_t& bucket : offsets)
+            {
+                const size_t bucketSize = bucket;
+                bucket = offset;
+                offset += bucketSize;
+            }
+
+            for (const SortEntry& entry : _sortEntries)
+            {
+                _sortScratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+            }
+
+            _sortEntries.swap(_sortScratch);
+        }
+    }
+
+    RenderStateChanges RenderQueue::countStateChanges() const
+    {
+        RenderStateChanges changes{};
+
+        const Shader* shader = nullptr;
+        uint32_t material = UINT32_MAX;
+        unsigned int vertexArray = UINT32_MAX;
+
+        for (const SortEntry& entry : _sortEntries)
+        {
+            const DrawItem& item = _items[entry.item];
+
+            if (item.shader != shader)
+            {
+                shader = item.shader;
+                material = UINT32_MAX;
+                changes.shaders++;
+            }
+
+            if (item.materialSlot != material)
+            {
+                material = item.materialSlot;
+                changes.materials++;
+            }
+
+            if (item.mesh->getVertexArray() != vertexArray)
+            {
+                vertexArray = item.mesh->getVertexArray();
+                changes.vertexArrays++;
+            }
+        }
+
+        return changes;
+    }
+}
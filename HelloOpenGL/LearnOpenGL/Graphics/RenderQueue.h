@@ -0,0 +1,99 @@
+﻿#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "../Math/Frustum.h"
+
+namespace LearnOpenGL::Model
+{
+    class Mesh;
+}
+
+namespace LearnOpenGL::Graphics
+{
+    struct RenderStateChanges
+    {
+        size_t shaders;
+        size_t materials;
+        size_t vertexArrays;
+    };
+
+    struct RenderQueueStats
+    {
+        size_t drawItems;
+        // meshes submitted but rejected by the frustum test
+        size_t culled;
+        // state changes the frame would have needed drawing items in the order they were submitted
+        RenderStateChanges submissionOrder;
+        RenderStateChanges sorted;
+    };
+
+    // Collects a frame's draws and issues them sorted by state, so shader, material and vertex array changes
+    // happen once per group rather than once per mesh.
+    class RenderQueue
+    {
+    public:
+        // Sort key layout, most significant first: shader (8 bits), material (24 bits), vertex array (16 bits), depth (16 bits).
+        static uint64_t makeSortKey(uint32_t shaderSlot, uint32_t materialSlot, uint32_t vertexArray, float normalizedDepth);
+
+        // Camera the next flush draws for; submitted meshes outside the frustum are dropped.
+        void setView(const glm::vec3& viewPosition, const Math::Frustum& frustum);
+        void setCullingEnabled(bool enabled);
+
+        void submit(const Shader& shader, const Model::Mesh& mesh, const glm::mat4& transform, const glm::mat3& normalMatrix);
+
+        // Sorts and draws everything submitted since the last flush, then empties the queue.
+        void flush();
+
+        [[nodiscard]] RenderQueueStats getStats() const;
+
+    private:
+        // distances past this all share the farthest depth bucket
+        static constexpr float MaxSortDistance = 1000.0f;
+
+        struct DrawItem
+        {
+            const Shader* shader;
+            const Model::Mesh* mesh;
+            glm::mat4 transform;
+            glm::mat3 normalMatrix;
+            uint32_t materialSlot;
+        };
+
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t item;
+        };
+
+        glm::vec3 _viewPosition{ 0.0f };
+        Math::Frustum _frustum;
+        bool _cullingEnabled = true;
+        size_t _culled = 0;
+
+        std::vector<DrawItem> _items;
+        std::vector<SortEntry> _sortEntries;
+        std::vector<SortEntry> _sortScratch;
+
+        // compact ids handed out on first sight, so programs and materials fit into their share of the key
+        std::unordered_map<unsigned int, uint32_t> _shaderSlots;
+        std::unordered_map<uint64_t, uint32_t> _materialSlots;
+
+        RenderQueueStats _stats{};
+
+        uint32_t getShaderSlot(unsigned int shaderId);
+        uint32_t getMaterialSlot(uint64_t materialKey);
+
+        void radixSort();
+        RenderStateChanges countStateChanges() const;
+    };
+}
+
+#endif // RENDER_QUEUE_H
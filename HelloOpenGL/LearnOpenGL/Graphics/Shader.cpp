@@ -1,47 +1,58 @@
 ﻿#include "Shader.h"
+#include <string_view>
+#include <utility>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "ShaderUtils.h"
-#include "../Utilities/FileUtils.h"
+#include "GLStateCache.h"
+#include "ShaderCompileBatch.h"
+#include "UniformBuffer.h"
 
 namespace LearnOpenGL::Graphics
 {
-    Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath)
+    static unsigned int buildProgram(const std::string& vertexPath, const std::string& fragmentPath)
     {
-        const std::string vertexShaderSource = Utilities::loadFile(vertexPath);
-        const std::string fragmentShaderSource = Utilities::loadFile(fragmentPath);
-
-        const unsigned int vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-        const unsigned int fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
+        ShaderCompileBatch batch;
+        batch.add(vertexPath, fragmentPath);
 
-        // can't link shaders to program if they didn't all compile
-        if (vertexShader == 0 || fragmentShader == 0)
-        {
-            _shaderId = 0;
-            return;
-        }
-
-        _shaderId = attachShaders({ vertexShader, fragmentShader });
+        return batch.finishPrograms().front();
+    }
 
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+    Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath)
+        : Shader(buildProgram(vertexPath, fragmentPath))
+    {
+    }
 
+    Shader::Shader(const unsigned int programId)
+        : _shaderId(programId)
+    {
+        reflectUniforms();
+        bindUniformBlocks();
         addReference(_shaderId);
     }
 
     Shader::Shader(const Shader& other)
-        : _shaderId(other._shaderId)
+        : _shaderId(other._shaderId), _uniforms(other._uniforms)
     {
         addReference(_shaderId);
     }
 
+    Shader::Shader(Shader&& other) noexcept
+        : _shaderId(std::exchange(other._shaderId, 0)), _uniforms(std::move(other._uniforms))
+    {
+    }
+
     Shader::~Shader()
     {
         removeReference(_shaderId);
     }
 
+    Shader Shader::fromProgram(const unsigned int programId)
+    {
+        return Shader(programId);
+    }
+
     unsigned int Shader::getId() const
     {
         return _shaderId;
@@ -49,37 +60,189 @@ namespace LearnOpenGL::Graphics
 
     void Shader::use() const
     {
-        glUseProgram(_shaderId);
+        GLStateCache::useProgram(_shaderId);
+    }
+
+    UniformHandle Shader::getUniform(const std::string& name) const
+    {
+        if (const auto uniform = _uniforms.find(name); uniform != _uniforms.end())
+        {
+            return uniform->second;
+        }
+
+        // not an active uniform at link time (or optimized out), so remember the miss as well.
+        UniformHandle uniform{ glGetUniformLocation(_shaderId, name.c_str()) };
+        _uniforms.insert({ name, uniform });
+
+        return uniform;
     }
 
     void Shader::setBool(const std::string& name, const bool value) const
     {
-        glUniform1i(glGetUniformLocation(_shaderId, name.c_str()), static_cast<int>(value));
+        setBool(getUniform(name), value);
     }
 
     void Shader::setInt(const std::string& name, const int value) const
     {
-        glUniform1i(glGetUniformLocation(_shaderId, name.c_str()), value);
+        setInt(getUniform(name), value);
     }
 
     void Shader::setFloat(const std::string& name, const float value) const
     {
-        glUniform1f(glGetUniformLocation(_shaderId, name.c_str()), value);
+        setFloat(getUniform(name), value);
     }
 
     void Shader::setMat4(const std::string& name, const glm::mat4& value, const GLboolean transposeMatrix) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(_shaderId, name.c_str()), 1, transposeMatrix, value_ptr(value));
+        setMat4(getUniform(name), value, transposeMatrix);
     }
 
     void Shader::setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(_shaderId, name.c_str()), 1, value_ptr(value));
+        setVec3(getUniform(name), value);
+    }
+
+    void Shader::setVec4(const std::string& name, const glm::vec4& value) const
+    {
+        setVec4(getUniform(name), value);
     }
 
     void Shader::setMat3(const std::string& name, const glm::mat3& value, const GLboolean transposeMatrix) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(_shaderId, name.c_str()), 1, transposeMatrix, value_ptr(value));
+        setMat3(getUniform(name), value, transposeMatrix);
+    }
+
+    void Shader::setBool(const UniformHandle& uniform, const bool value) const
+    {
+        if (uniform.isValid())
+        {
+            glUniform1i(uniform.location, static_cast<int>(value));
+        }
+    }
+
+    void Shader::setInt(const UniformHandle& uniform, const int value) const
+    {
+        if (uniform.isValid())
+        {
+            glUniform1i(uniform.location, value);
+        }
+    }
+
+    void Shader::setFloat(const UniformHandle& uniform, const float value) const
+    {
+        if (uniform.isValid())
+        {
+            glUniform1f(uniform.location, value);
+        }
+    }
+
+    void Shader::setMat4(const UniformHandle& uniform, const glm::mat4& value, const GLboolean transposeMatrix) const
+    {
+        if (uniform.isValid())
+        {
+            glUniformMatrix4fv(uniform.location, 1, transposeMatrix, value_ptr(value));
+        }
+    }
+
+    void Shader::setVec3(const UniformHandle& uniform, const glm::vec3& value) const
+    {
+        if (uniform.isValid())
+        {
+            glUniform3fv(uniform.location, 1, value_ptr(value));
+        }
+    }
+
+    void Shader::setVec4(const UniformHandle& uniform, const glm::vec4& value) const
+    {
+        if (uniform.isValid())
+        {
+            glUniform4fv(uniform.location, 1, value_ptr(value));
+        }
+    }
+
+    void Shader::setMat3(const UniformHandle& uniform, const glm::mat3& value, const GLboolean transposeMatrix) const
+    {
+        if (uniform.isValid())
+        {
+            glUniformMatrix3fv(uniform.location, 1, transposeMatrix, value_ptr(value));
+        }
+    }
+
+    void Shader::reflectUniforms()
+    {
+        _uniforms.clear();
+
+        if (!_shaderId)
+        {
+            return;
+        }
+
+        GLint uniformCount = 0;
+        GLint maxNameLength = 0;
+        glGetProgramiv(_shaderId, GL_ACTIVE_UNIFORMS, &uniformCount);
+        glGetProgramiv(_shaderId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::string nameBuffer(static_cast<size_t>(maxNameLength), '\0');
+
+        for (GLint i = 0; i < uniformCount; i++)
+        {
+            GLsizei nameLength = 0;
+            GLint size = 0;
+            GLenum type = GL_NONE;
+            glGetActiveUniform(_shaderId, static_cast<GLuint>(i), maxNameLength, &nameLength, &size, &type, nameBuffer.data());
+
+            std::string name = nameBuffer.substr(0, static_cast<size_t>(nameLength));
+            const GLint location = glGetUniformLocation(_shaderId, name.c_str());
+
+            // members of uniform blocks have no location
+            if (location < 0)
+            {
+                continue;
+            }
+
+            _uniforms.insert({ name, { location, type, size } });
+
+            // arrays of basic types are only reported once as "name[0]", so register the base name and every element.
+            // element locations are not guaranteed to be contiguous, so each one is queried on its own.
+            constexpr std::string_view firstElement = "[0]";
+
+            if (size > 1 && name.ends_with(firstElement))
+            {
+                const std::string baseName = name.substr(0, name.size() - firstElement.size());
+                _uniforms.insert({ baseName, { location, type, size } });
+
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = baseName + '[' + std::to_string(element) + ']';
+                    const GLint elementLocation = glGetUniformLocation(_shaderId, elementName.c_str());
+                    _uniforms.insert({ std::move(elementName), { elementLocation, type, 1 } });
+                }
+            }
+        }
+    }
+
+    void Shader::bindUniformBlocks() const
+    {
+        if (!_shaderId)
+        {
+            return;
+        }
+
+        GLint blockCount = 0;
+        GLint maxNameLength = 0;
+        glGetProgramiv(_shaderId, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+        glGetProgramiv(_shaderId, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+
+        std::string nameBuffer(static_cast<size_t>(maxNameLength), '\0');
+
+        for (GLint i = 0; i < blockCount; i++)
+        {
+            GLsizei nameLength = 0;
+            glGetActiveUniformBlockName(_shaderId, static_cast<GLuint>(i), maxNameLength, &nameLength, nameBuffer.data());
+
+            const std::string blockName = nameBuffer.substr(0, static_cast<size_t>(nameLength));
+            glUniformBlockBinding(_shaderId, static_cast<GLuint>(i), UniformBuffer::getBindingPoint(blockName));
+        }
     }
 
     void Shader::addReference(const unsigned int shaderId)
@@ -112,13 +275,29 @@ namespace LearnOpenGL::Graphics
         {
             glDeleteProgram(shaderId);
             _shaderReferences.erase(shaderId);
+            GLStateCache::onProgramDeleted(shaderId);
         }
     }
 
     Shader& Shader::operator=(const Shader& other)
     {
+        addReference(other._shaderId);
+        removeReference(_shaderId);
+
         _shaderId = other._shaderId;
-        addReference(_shaderId);
+        _uniforms = other._uniforms;
+
+        return *this;
+    }
+
+    Shader& Shader::operator=(Shader&& other) noexcept
+    {
+        if (this != &other)
+        {
+            removeReference(_shaderId);
+            _shaderId = std::exchange(other._shaderId, 0);
+            _uniforms = std::move(other._uniforms);
+        }
 
         return *this;
     }
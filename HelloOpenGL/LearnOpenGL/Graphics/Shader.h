@@ -9,33 +9,68 @@
 
 namespace LearnOpenGL::Graphics
 {
+    struct UniformHandle
+    {
+        GLint location = -1;
+        GLenum type = GL_NONE;
+        GLint size = 0;
+
+        [[nodiscard]] bool isValid() const
+        {
+            return location >= 0;
+        }
+    };
+
     class Shader
     {
     public:
+        // Builds the program right away; use a ShaderCompileBatch to build several without waiting on each.
         Shader(const std::string& vertexPath, const std::string& fragmentPath);
         Shader(const Shader& other);
-        Shader(Shader&&) noexcept = default;
+        Shader(Shader&& other) noexcept;
 
         Shader& operator=(const Shader& other);
-        Shader& operator=(Shader&&) = default;
+        Shader& operator=(Shader&& other) noexcept;
 
         ~Shader();
 
+        // Takes over a linked program, or 0 for one that failed to build.
+        static Shader fromProgram(unsigned int programId);
+
         [[nodiscard]] unsigned int getId() const;
 
         void use() const;
 
+        // Resolves a uniform once so hot paths can skip the name lookup entirely.
+        // Names that were not found when the program was linked are queried from GL once and cached.
+        [[nodiscard]] UniformHandle getUniform(const std::string& name) const;
+
         void setBool(const std::string& name, bool value) const;
         void setInt(const std::string& name, int value) const;
         void setFloat(const std::string& name, float value) const;
         void setMat4(const std::string& name, const glm::mat4& value, GLboolean transposeMatrix = GL_FALSE) const;
         void setVec3(const std::string& name, const glm::vec3& value) const;
+        void setVec4(const std::string& name, const glm::vec4& value) const;
         void setMat3(const std::string& name, const glm::mat3& value, GLboolean transposeMatrix = GL_FALSE) const;
 
+        void setBool(const UniformHandle& uniform, bool value) const;
+        void setInt(const UniformHandle& uniform, int value) const;
+        void setFloat(const UniformHandle& uniform, float value) const;
+        void setMat4(const UniformHandle& uniform, const glm::mat4& value, GLboolean transposeMatrix = GL_FALSE) const;
+        void setVec3(const UniformHandle& uniform, const glm::vec3& value) const;
+        void setVec4(const UniformHandle& uniform, const glm::vec4& value) const;
+        void setMat3(const UniformHandle& uniform, const glm::mat3& value, GLboolean transposeMatrix = GL_FALSE) const;
+
     private:
         inline static std::pmr::unordered_map<unsigned int, unsigned int> _shaderReferences{ {} };
 
-        unsigned int _shaderId;
+        unsigned int _shaderId{};
+        mutable std::unordered_map<std::string, UniformHandle> _uniforms;
+
+        explicit Shader(unsigned int programId);
+
+        void reflectUniforms();
+        void bindUniformBlocks() const;
 
         static void addReference(unsigned int shaderId);
         static void removeReference(unsigned int shaderId);
@@ -0,0 +1,167 @@
+﻿#include "ShaderCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "../Utilities/Hash.h"
+
+namespace LearnOpenGL::Graphics
+{
+    static constexpr char ShaderCacheMagic[8] = { 'L', 'O', 'G', 'L', 'P', 'R', 'O', 'G' };
+
+    void ShaderCache::setDirectory(const std::string& directory)
+    {
+        _directory = directory;
+    }
+
+    unsigned int ShaderCache::load(const uint64_t sourceHash)
+    {
+        if (!GLExtensions::supportsProgramBinary())
+        {
+            return 0;
+        }
+
+        const auto loadStart = std::chrono::steady_clock::now();
+        std::ifstream file(getEntryPath(sourceHash), std::ios::binary);
+        ShaderCacheHeader header{};
+
+        if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, ShaderCacheMagic, sizeof(ShaderCacheMagic)) != 0
+            || header.version != ShaderCacheVersion
+            || header.sourceHash != sourceHash
+            || header.driverHash != getDriverHash()
+            || header.binarySize == 0)
+        {
+            _stats.misses++;
+            return 0;
+        }
+
+        std::vector<char> binary(static_cast<size_t>(header.binarySize));
+
+        if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+        {
+            _stats.misses++;
+            return 0;
+        }
+
+        const unsigned int program = glCreateProgram();
+        GLExtensions::programBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        // the driver reports a binary it no longer accepts as a failed link
+        int linkSuccess;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkSuccess);
+
+        if (!linkSuccess)
+        {
+            glDeleteProgram(program);
+            _stats.misses++;
+            _stats.rejected++;
+
+            return 0;
+        }
+
+        const double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        _stats.hits++;
+        _stats.loadMilliseconds += loadMilliseconds;
+        _stats.millisecondsSaved += static_cast<double>(header.compileMicroseconds) / 1000.0 - loadMilliseconds;
+
+        return program;
+    }
+
+    void ShaderCache::store(const uint64_t sourceHash, const unsigned int program, const double compileMilliseconds)
+    {
+        _stats.compileMilliseconds += compileMilliseconds;
+
+        if (!program || !GLExtensions::supportsProgramBinary())
+        {
+            return;
+        }
+
+        GLint binarySize = 0;
+        glGetProgramiv(program, ProgramBinaryLength, &binarySize);
+
+        if (binarySize <= 0)
+        {
+            return;
+        }
+
+        std::vector<char> binary(static_cast<size_t>(binarySize));
+        GLsizei length = 0;
+        GLenum binaryFormat = GL_NONE;
+        GLExtensions::getProgramBinary(program, binarySize, &length, &binaryFormat, binary.data());
+
+        if (length <= 0)
+        {
+            return;
+        }
+
+        ShaderCacheHeader header{};
+        std::memcpy(header.magic, ShaderCacheMagic, sizeof(ShaderCacheMagic));
+        header.version = ShaderCacheVersion;
+        header.binaryFormat = binaryFormat;
+        header.sourceHash = sourceHash;
+        header.driverHash = getDriverHash();
+        header.binarySize = static_cast<uint64_t>(length);
+        header.compileMicroseconds = static_cast<uint64_t>(compileMilliseconds * 1000.0);
+
+        std::error_code error;
+        std::filesystem::create_directories(_directory, error);
+
+        const std::string entryPath = getEntryPath(sourceHash);
+        std::ofstream file(entryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            std::cerr << "Unable to open shader cache entry at " << entryPath << " for writing.\n";
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+
+        if (!file)
+        {
+            std::cerr << "Error while writing shader cache entry at " << entryPath << ".\n";
+        }
+    }
+
+    ShaderCacheStats ShaderCache::getStats()
+    {
+        return _stats;
+    }
+
+    std::string ShaderCache::getEntryPath(const uint64_t sourceHash)
+    {
+        // one file per driver as well, so switching GPUs does not keep overwriting the same entries
+        char name[48];
+        std::snprintf(name, sizeof(name), "%016llx-%016llx.progbin", static_cast<unsigned long long>(sourceHash),
+                      static_cast<unsigned long long>(getDriverHash()));
+
+        return (std::filesystem::path(_directory) / name).string();
+    }
+
+    uint64_t ShaderCache::getDriverHash()
+    {
+        static const uint64_t driverHash = []
+        {
+            uint64_t hash = Utilities::HashSeed;
+
+            for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+            {
+                const auto* value = reinterpret_cast<const char*>(glGetString(name));
+                hash = Utilities::hashString(value ? value : "", hash);
+            }
+
+            return hash;
+        }();
+
+        return driverHash;
+    }
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace LearnOpenGL::Graphics
+{
+    // Bump whenever ShaderCacheHeader or how programs are linked before being stored changes.
+    constexpr uint32_t ShaderCacheVersion = 1;
+
+    struct ShaderCacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint64_t sourceHash;
+        // vendor, renderer and version strings; binaries only load on the driver that produced them
+        uint64_t driverHash;
+        uint64_t binarySize;
+        // what building the program from source took, to report the time a cache hit saves
+        uint64_t compileMicroseconds;
+    };
+
+    struct ShaderCacheStats
+    {
+        size_t hits;
+        size_t misses;
+        // entries found on disk that the driver refused, e.g. after a driver update with the same version string
+        size_t rejected;
+        double loadMilliseconds;
+        double compileMilliseconds;
+        double millisecondsSaved;
+    };
+
+    // Keeps linked program binaries on disk, so later runs skip compiling and linking shaders the driver has seen before.
+    // Entries are keyed by the hash of every source the program was built from, plus the driver. Does nothing when the
+    // context cannot retrieve program binaries. Only use from the thread owning the GL context.
+    class ShaderCache
+    {
+    public:
+        // Relative to the working directory, like the shader sources themselves.
+        static void setDirectory(const std::string& directory);
+
+        // Creates a program from the entry for sourceHash. Returns 0 if there is none or the driver rejected it,
+        // in which case the program has to be built from source and passed to store().
+        static unsigned int load(uint64_t sourceHash);
+        static void store(uint64_t sourceHash, unsigned int program, double compileMilliseconds);
+
+        [[nodiscard]] static ShaderCacheStats getStats();
+
+    private:
+        inline static std::string _directory = "ShaderCache";
+        inline static ShaderCacheStats _stats{};
+
+        static std::string getEntryPath(uint64_t sourceHash);
+        static uint64_t getDriverHash();
+    };
+}
+
+#endif // SHADER_CACHE_H
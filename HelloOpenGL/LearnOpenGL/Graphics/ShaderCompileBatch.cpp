@@ -0,0 +1,187 @@
+﻿#include "ShaderCompileBatch.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "GLExtensions.h"
+#include "ShaderCache.h"
+#include "ShaderUtils.h"
+#include "../Utilities/Hash.h"
+
+namespace LearnOpenGL::Graphics
+{
+    size_t ShaderCompileBatch::add(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines,
+                                   const std::string& geometryPath)
+    {
+        Program program{};
+        program.stages.emplace_back(GL_VERTEX_SHADER, preprocessShader(vertexPath, defines));
+
+        if (!geometryPath.empty())
+        {
+            program.stages.emplace_back(GL_GEOMETRY_SHADER, preprocessShader(geometryPath, defines));
+        }
+
+        program.stages.emplace_back(GL_FRAGMENT_SHADER, preprocessShader(fragmentPath, defines));
+
+        // hashing the expanded sources picks up edits to included files and every define; the stage types go into the
+        // hash too, so moving code between stages never hits a stale entry
+        program.sourceHash = Utilities::HashSeed;
+
+        for (const auto& [type, source] : program.stages)
+        {
+            program.sourceHash = Utilities::hashString(source, Utilities::hashBytes(&type, sizeof(type), program.sourceHash));
+        }
+
+        _programs.push_back(std::move(program));
+        return _programs.size() - 1;
+    }
+
+    void ShaderCompileBatch::submit()
+    {
+        if (_isSubmitted)
+        {
+            return;
+        }
+
+        _isSubmitted = true;
+        _submitted = std::chrono::steady_clock::now();
+        GLExtensions::useAllShaderCompilerThreads();
+
+        for (Program& program : _programs)
+        {
+            program.program = ShaderCache::load(program.sourceHash);
+            program.cached = program.program != 0;
+
+            if (program.cached)
+            {
+                continue;
+            }
+
+            for (const auto& [type, source] : program.stages)
+            {
+                program.shaders.push_back(submitShader(source, type));
+            }
+        }
+
+        // links go in only after every compile, so no program waits on its stages while others could still be submitted
+        for (Program& program : _programs)
+        {
+            if (!program.cached)
+            {
+                program.program = submitProgram(program.shaders);
+            }
+        }
+    }
+
+    bool ShaderCompileBatch::isComplete() const
+    {
+        if (!_isSubmitted)
+        {
+            return false;
+        }
+
+        if (!GLExtensions::supportsParallelShaderCompile() || _isCompleted)
+        {
+            return true;
+        }
+
+        for (const Program& program : _programs)
+        {
+            GLint completed = GL_TRUE;
+
+            if (!program.cached)
+            {
+                glGetProgramiv(program.program, CompletionStatus, &completed);
+            }
+
+            if (!completed)
+            {
+                return false;
+            }
+        }
+
+        _completed = std::chrono::steady_clock::now();
+        _isCompleted = true;
+
+        return true;
+    }
+
+    std::vector<Shader> ShaderCompileBatch::finish()
+    {
+        const std::vector<unsigned int> programIds = finishPrograms();
+
+        std::vector<Shader> shaders;
+        shaders.reserve(programIds.size());
+
+        for (const unsigned int programId : programIds)
+        {
+            shaders.push_back(Shader::fromProgram(programId));
+        }
+
+        return shaders;
+    }
+
+    std::vector<unsigned int> ShaderCompileBatch::finishPrograms()
+    {
+        submit();
+
+        std::vector<unsigned int> programIds;
+        programIds.reserve(_programs.size());
+
+        size_t compiled = 0;
+        const auto sourceBuilds = std::ranges::count_if(_programs, [](const Program& program) { return !program.cached; });
+
+        for (Program& program : _programs)
+        {
+            if (!program.cached)
+            {
+                bool success = checkProgram(program.program);
+
+                // a failed link is most likely a failed compile, whose log says more
+                if (!success)
+                {
+                    for (size_t i = 0; i < program.shaders.size(); i++)
+                    {
+                        checkShader(program.shaders[i], program.stages[i].first);
+                    }
+
+                    glDeleteProgram(program.program);
+                    program.program = 0;
+                }
+
+                for (const unsigned int shader : program.shaders)
+                {
+                    glDeleteShader(shader);
+                }
+
+                if (success)
+                {
+                    // stages compile side by side, so each program is charged an even share of the whole batch
+                    ShaderCache::store(program.sourceHash, program.program, getBuildMilliseconds() / static_cast<double>(sourceBuilds));
+                    compiled++;
+                }
+            }
+
+            programIds.push_back(program.program);
+        }
+
+        if (compiled > 0)
+        {
+            std::cerr << "Built " << compiled << " of " << _programs.size() << " shader programs from source in "
+                << getBuildMilliseconds() << " ms ("
+                << (GLExtensions::supportsParallelShaderCompile() ? "parallel" : "deferred status queries") << ").\n";
+        }
+
+        _programs.clear();
+        _isSubmitted = false;
+        _isCompleted = false;
+
+        return programIds;
+    }
+
+    double ShaderCompileBatch::getBuildMilliseconds() const
+    {
+        const auto end = _isCompleted ? _completed : std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - _submitted).count();
+    }
+}
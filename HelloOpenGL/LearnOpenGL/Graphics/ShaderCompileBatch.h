@@ -0,0 +1,60 @@
+﻿#pragma once
+#ifndef SHADER_COMPILE_BATCH_H
+#define SHADER_COMPILE_BATCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "ShaderUtils.h"
+
+namespace LearnOpenGL::Graphics
+{
+    // Builds several programs at once: submit() hands every stage and link to GL before anything asks for a result, so
+    // drivers with parallel shader compilation work on all of them in the background while the caller does other
+    // loading. Without KHR_parallel_shader_compile every status query is simply put off until finish().
+    // Programs in the ShaderCache are loaded from it instead. Only use from the thread owning the GL context.
+    class ShaderCompileBatch
+    {
+    public:
+        // Reads and preprocesses the sources right away, adding the defines to every stage. Returns the program's index
+        // in what finish() returns.
+        size_t add(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = {},
+                   const std::string& geometryPath = "");
+
+        void submit();
+        // Never waits on the compiler. Always true once submitted when the driver cannot report progress.
+        [[nodiscard]] bool isComplete() const;
+
+        // Waits for every program and reports failures; failed programs come back with id 0.
+        std::vector<Shader> finish();
+        // Same, handing out the raw program ids, which the caller then owns.
+        std::vector<unsigned int> finishPrograms();
+
+    private:
+        struct Program
+        {
+            std::vector<std::pair<GLuint, std::string>> stages;
+            uint64_t sourceHash;
+            std::vector<unsigned int> shaders;
+            unsigned int program;
+            bool cached;
+        };
+
+        std::vector<Program> _programs;
+        std::chrono::steady_clock::time_point _submitted;
+        // when isComplete() first saw every program done, so build times leave out what the caller did afterwards
+        mutable std::chrono::steady_clock::time_point _completed;
+        mutable bool _isCompleted = false;
+        bool _isSubmitted = false;
+
+        [[nodiscard]] double getBuildMilliseconds() const;
+    };
+}
+
+#endif // SHADER_COMPILE_BATCH_H
@@ -1,10 +1,17 @@
 ﻿#include "ShaderUtils.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <glad/glad.h>
 
+#include "GLExtensions.h"
+#include "../Utilities/FileUtils.h"
+
 namespace LearnOpenGL::Graphics
 {
     static const std::unordered_map<GLuint, std::string> ShaderNames = {
@@ -13,7 +20,118 @@ namespace LearnOpenGL::Graphics
         { GL_GEOMETRY_SHADER, "Geometry" },
     };
 
+    static bool expandIncludes(const std::filesystem::path& path, const ShaderDefines& defines, std::vector<std::string>& files,
+                               std::string& output)
+    {
+        constexpr std::string_view includeDirective = "#include";
+        constexpr std::string_view versionDirective = "#version";
+
+        if (!std::filesystem::exists(path))
+        {
+            std::cerr << "Unable to find shader source " << path.generic_string() << ".\n";
+            return false;
+        }
+
+        const auto fileIndex = files.size();
+        files.push_back(path.lexically_normal().generic_string());
+
+        std::istringstream source(Utilities::loadFile(path.string()));
+        std::string line;
+        size_t lineNumber = 0;
+
+        while (std::getline(source, line))
+        {
+            lineNumber++;
+
+            const std::string_view directive = std::string_view(line).substr(std::min(line.find_first_not_of(" \t"), line.size()));
+
+            if (fileIndex == 0 && directive.starts_with(versionDirective))
+            {
+                output.append(line).append("\n");
+
+                for (const auto& [name, value] : defines)
+                {
+                    output.append("#define ").append(name).append(" ").append(value).append("\n");
+                }
+
+                output.append("#line ").append(std::to_string(lineNumber + 1)).append(" 0\n");
+                continue;
+            }
+
+            if (!directive.starts_with(includeDirective))
+            {
+                output.append(line).append("\n");
+                continue;
+            }
+
+            const size_t nameStart = directive.find('"');
+            const size_t nameEnd = nameStart == std::string_view::npos ? nameStart : directive.find('"', nameStart + 1);
+
+            if (nameEnd == std::string_view::npos)
+            {
+                std::cerr << "Malformed #include in " << path.generic_string() << " at line " << lineNumber << "\n";
+                return false;
+            }
+
+            const std::filesystem::path includePath = path.parent_path() / directive.substr(nameStart + 1, nameEnd - nameStart - 1);
+
+            // also what stops include cycles
+            if (std::ranges::find(files, includePath.lexically_normal().generic_string()) == files.end())
+            {
+                output.append("#line 1 ").append(std::to_string(files.size())).append("\n");
+
+                if (!expandIncludes(includePath, defines, files, output))
+                {
+                    return false;
+                }
+            }
+
+            output.append("#line ").append(std::to_string(lineNumber + 1)).append(" ").append(std::to_string(fileIndex)).append("\n");
+        }
+
+        return true;
+    }
+
+    std::string preprocessShader(const std::string& shaderPath, const ShaderDefines& defines)
+    {
+        std::vector<std::string> files;
+        std::string output;
+
+        if (!expandIncludes(shaderPath, defines, files, output))
+        {
+            return {};
+        }
+
+        return output;
+    }
+
     unsigned int compileShader(const std::string& shaderSource, const GLuint& shaderType)
+    {
+        const unsigned int shader = submitShader(shaderSource, shaderType);
+
+        if (!checkShader(shader, shaderType))
+        {
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    unsigned int attachShaders(const std::initializer_list<unsigned int>& shaders)
+    {
+        const unsigned int shaderProgram = submitProgram(std::span(shaders.begin(), shaders.size()));
+
+        if (!checkProgram(shaderProgram))
+        {
+            glDeleteProgram(shaderProgram);
+            return 0;
+        }
+
+        return shaderProgram;
+    }
+
+    unsigned int submitShader(const std::string& shaderSource, const GLuint shaderType)
     {
         const unsigned int shader = glCreateShader(shaderType);
 
@@ -22,6 +140,31 @@ namespace LearnOpenGL::Graphics
 
         glCompileShader(shader);
 
+        return shader;
+    }
+
+    unsigned int submitProgram(const std::span<const unsigned int> shaders)
+    {
+        const unsigned int shaderProgram = glCreateProgram();
+
+        for (const unsigned int shader : shaders)
+        {
+            glAttachShader(shaderProgram, shader);
+        }
+
+        // lets the ShaderCache read the linked binary back
+        if (GLExtensions::supportsProgramBinary())
+        {
+            GLExtensions::programParameteri(shaderProgram, ProgramBinaryRetrievableHint, GL_TRUE);
+        }
+
+        glLinkProgram(shaderProgram);
+
+        return shaderProgram;
+    }
+
+    bool checkShader(const unsigned int shader, const GLuint shaderType)
+    {
         int shaderCompileSuccess;
         glGetShaderiv(shader, GL_COMPILE_STATUS, &shaderCompileSuccess);
 
@@ -31,38 +174,30 @@ namespace LearnOpenGL::Graphics
             glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
             std::cerr << "ERROR: " << ShaderNames.at(shaderType) << " Graphics Compilation Failed\n" << infoLog << '\n';
 
-            return 0;
+            return false;
         }
 
         std::cerr << "Successfully compiled " << ShaderNames.at(shaderType) << " shader.\n";
 
-        return shader;
+        return true;
     }
-    unsigned int attachShaders(const std::initializer_list<unsigned int>& shaders)
-    {
-        const unsigned int shaderProgram = glCreateProgram();
-
-        for (const unsigned int shader : shaders)
-        {
-            glAttachShader(shaderProgram, shader);
-        }
-
-        glLinkProgram(shaderProgram);
 
+    bool checkProgram(const unsigned int program)
+    {
         int shaderLinkSuccess;
-        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &shaderLinkSuccess);
+        glGetProgramiv(program, GL_LINK_STATUS, &shaderLinkSuccess);
 
         if (!shaderLinkSuccess)
         {
             char infoLog[512];
-            glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
             std::cerr << "ERROR: Graphics Program Linking Failed\n" << infoLog << '\n';
 
-            return 0;
+            return false;
         }
 
         std::cerr << "Successfully attached all shaders.\n";
 
-        return shaderProgram;
+        return true;
     }
 }
@@ -3,13 +3,32 @@
 #ifndef SHADER_UTILS_H
 #define SHADER_UTILS_H
 
+#include <span>
 #include <string>
+#include <utility>
+#include <vector>
 #include <glad/glad.h>
 
 namespace LearnOpenGL::Graphics
 {
+    // name and value of each #define injected into a shader's source
+    using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+    // Loads a shader source, expanding #include "file" lines (relative to the including file, each file only once per
+    // source, regardless of surrounding #if blocks) and adding defines right after the #version line.
+    // #line directives keep compiler messages pointing at the right line; their source string number is the order in
+    // which files were first included, the loaded file being 0.
+    std::string preprocessShader(const std::string& shaderPath, const ShaderDefines& defines = {});
+
     unsigned int compileShader(const std::string& shaderSource, const GLuint& shaderType);
     unsigned int attachShaders(const std::initializer_list<unsigned int>& shaders);
+
+    // compileShader and attachShaders in two halves: the submit functions return as soon as GL has the work, so the driver
+    // can compile several stages and programs at once, and the check functions wait for the result and report failures.
+    unsigned int submitShader(const std::string& shaderSource, GLuint shaderType);
+    unsigned int submitProgram(std::span<const unsigned int> shaders);
+    bool checkShader(unsigned int shader, GLuint shaderType);
+    bool checkProgram(unsigned int program);
 }
 
 #endif // SHADER_UTILS_H
@@ -0,0 +1,115 @@
+﻿#include "ShaderVariants.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "ShaderCompileBatch.h"
+#include "UniformBlocks.h"
+
+namespace LearnOpenGL::Graphics
+{
+    uint64_t ShaderPermutation::getKey() const
+    {
+        return static_cast<uint64_t>(features) << 32 | pointLights;
+    }
+
+    ShaderDefines ShaderPermutation::getDefines() const
+    {
+        ShaderDefines defines{ { "SHADER_VARIANT", "1" } };
+
+        if (features & ShaderFeatureTextures2D)
+        {
+            defines.emplace_back("TEXTURES_2D", "1");
+        }
+
+        if (features & ShaderFeatureTextureArrays)
+        {
+            defines.emplace_back("TEXTURE_ARRAYS", "1");
+        }
+
+        if (features & ShaderFeatureDrawTable)
+        {
+            defines.emplace_back("DRAW_TABLE", "1");
+        }
+
+        if (features & ShaderFeatureSpotLight)
+        {
+            defines.emplace_back("SPOT_LIGHT", "1");
+        }
+
+        if (features & ShaderFeatureClusteredLights)
+        {
+            defines.emplace_back("CLUSTERED_LIGHTS", "1");
+        }
+
+        defines.emplace_back("POINT_LIGHTS", std::to_string(std::min<uint32_t>(pointLights, MaxPointLights)));
+
+        return defines;
+    }
+
+    ShaderVariants::ShaderVariants(std::string vertexPath, std::string fragmentPath, std::function<void(const Shader&)> setup)
+        : _vertexPath(std::move(vertexPath)), _fragmentPath(std::move(fragmentPath)), _setup(std::move(setup))
+    {
+    }
+
+    void ShaderVariants::prepare(const std::span<const ShaderPermutation> permutations)
+    {
+        ShaderCompileBatch batch;
+        std::vector<uint64_t> keys;
+
+        for (const ShaderPermutation& permutation : permutations)
+        {
+            const uint64_t key = permutation.getKey();
+
+            if (_variants.contains(key) || std::ranges::find(keys, key) != keys.end())
+            {
+                continue;
+            }
+
+            batch.add(_vertexPath, _fragmentPath, permutation.getDefines());
+            keys.push_back(key);
+        }
+
+        if (keys.empty())
+        {
+            return;
+        }
+
+        const std::vector<unsigned int> programIds = batch.finishPrograms();
+
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            addVariant(keys[i], programIds[i]);
+        }
+    }
+
+    const Shader& ShaderVariants::get(const ShaderPermutation& permutation)
+    {
+        const auto variant = _variants.find(permutation.getKey());
+
+        if (variant != _variants.end())
+        {
+            return *variant->second;
+        }
+
+        prepare({ &permutation, 1 });
+        return *_variants.at(permutation.getKey());
+    }
+
+    size_t ShaderVariants::getVariantCount() const
+    {
+        return _variants.size();
+    }
+
+    void ShaderVariants::addVariant(const uint64_t key, const unsigned int programId)
+    {
+        auto& shader = _variants[key] = std::make_unique<Shader>(Shader::fromProgram(programId));
+
+        if (programId != 0 && _setup)
+        {
+            shader->use();
+            _setup(*shader);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "Shader.h"
+#include "ShaderUtils.h"
+
+namespace LearnOpenGL::Graphics
+{
+    // features a variant is compiled with, see shader_features.glsl
+    constexpr uint32_t ShaderFeatureTextures2D = 1u << 0;
+    constexpr uint32_t ShaderFeatureTextureArrays = 1u << 1;
+    constexpr uint32_t ShaderFeatureDrawTable = 1u << 2;
+    constexpr uint32_t ShaderFeatureSpotLight = 1u << 3;
+    // point lights come from LightClusters instead of LightUniforms, so pointLights is ignored
+    constexpr uint32_t ShaderFeatureClusteredLights = 1u << 4;
+
+    struct ShaderPermutation
+    {
+        uint32_t features = 0;
+        // upper bound of the point light loop, at most MaxPointLights
+        uint32_t pointLights = 0;
+
+        [[nodiscard]] uint64_t getKey() const;
+        // SHADER_VARIANT, one define per feature and POINT_LIGHTS
+        [[nodiscard]] ShaderDefines getDefines() const;
+    };
+
+    // Specialized builds of one vertex and fragment shader pair, compiled once per permutation and kept for the
+    // lifetime of the object. Shaders handed out never move, so render queues may hold on to them.
+    class ShaderVariants
+    {
+    public:
+        // setup runs once on every new variant, for uniforms that never change such as sampler units
+        ShaderVariants(std::string vertexPath, std::string fragmentPath, std::function<void(const Shader&)> setup = {});
+
+        // Builds every permutation not built yet in one ShaderCompileBatch, so they compile side by side.
+        void prepare(std::span<const ShaderPermutation> permutations);
+        // Builds the permutation on first use, waiting for the compiler. Failed builds are kept too, as program 0.
+        const Shader& get(const ShaderPermutation& permutation);
+
+        [[nodiscard]] size_t getVariantCount() const;
+
+    private:
+        std::string _vertexPath;
+        std::string _fragmentPath;
+        std::function<void(const Shader&)> _setup;
+        std::unordered_map<uint64_t, std::unique_ptr<Shader>> _variants;
+
+        void addVariant(uint64_t key, unsigned int programId);
+    };
+}
+
+#endif // SHADER_VARIANTS_H
@@ -3,7 +3,12 @@
 #include <array>
 #include <iostream>
 #include <ostream>
-#include <stb/stb_image.h>
+#include <utility>
+
+#include "GLStateCache.h"
+#include "Image.h"
+#include "TextureRegistry.h"
+#include "UploadScheduler.h"
 
 namespace LearnOpenGL::Graphics
 {
@@ -19,21 +24,18 @@ namespace LearnOpenGL::Graphics
             return;
         }
 
-        int imageWidth;
-        int imageHeight;
-        int numberChannels;
-        unsigned char* imageData = stbi_load(texturePath.c_str(), &imageWidth, &imageHeight, &numberChannels, 0);
+        Image image = Image::loadFromFile(texturePath);
 
-        if (imageData)
+        if (image.isValid())
         {
             GLint internalFormat;
             GLint dataFormat;
-            if (numberChannels == 3)
+            if (image.getChannels() == 3)
             {
                 dataFormat = GL_RGB;
                 internalFormat = useSRGB ? GL_SRGB : GL_RGB;
             }
-            else if (numberChannels == 4)
+            else if (image.getChannels() == 4)
             {
                 dataFormat = GL_RGBA;
                 internalFormat = useSRGB ? GL_SRGB_ALPHA : GL_RGBA;
@@ -46,20 +48,18 @@ namespace LearnOpenGL::Graphics
 
             bind();
 
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, imageWidth, imageHeight, 0, dataFormat, GL_UNSIGNED_BYTE, imageData);
-
-            if (useMipmaps)
-            {
-                glGenerateMipmap(GL_TEXTURE_2D);
-            }
+            // storage only; the pixels stream in through the scheduler
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.getWidth(), image.getHeight(), 0, dataFormat, GL_UNSIGNED_BYTE, nullptr);
+            UploadScheduler::getShared().uploadTexture(_textureId, std::move(image), useMipmaps);
         }
         else
         {
             std::cerr << "Failed to load texture at " << texturePath << "\n";
         }
 
-        stbi_image_free(imageData);
         unbind();
+
+        addReference(_textureId);
     }
 
     Texture2D::Texture2D(const Texture2D& other)
@@ -68,13 +68,40 @@ namespace LearnOpenGL::Graphics
         addReference(_textureId);
     }
 
+    Texture2D::Texture2D(Texture2D&& other) noexcept
+        : _textureId(std::exchange(other._textureId, 0))
+    {
+    }
+
     Texture2D& Texture2D::operator=(const Texture2D& other)
     {
+        addReference(other._textureId);
+        removeReference(_textureId);
+
         _textureId = other._textureId;
-        addReference(_textureId);
         return *this;
     }
 
+    Texture2D& Texture2D::operator=(Texture2D&& other) noexcept
+    {
+        if (this != &other)
+        {
+            removeReference(_textureId);
+            _textureId = std::exchange(other._textureId, 0);
+        }
+
+        return *this;
+    }
+
+    Texture2D Texture2D::fromId(const unsigned int textureId)
+    {
+        Texture2D texture;
+        texture._textureId = textureId;
+        addReference(textureId);
+
+        return texture;
+    }
+
     unsigned int Texture2D::getId() const
     {
         return _textureId;
@@ -82,18 +109,22 @@ namespace LearnOpenGL::Graphics
 
     void Texture2D::use(const GLenum activeTexture) const
     {
-        glActiveTexture(activeTexture);
+        // DefaultTexture is not a texture unit; keep whichever unit is active
+        if (activeTexture != DefaultTexture)
+        {
+            GLStateCache::activeTexture(activeTexture);
+        }
+
         bind();
     }
 
     void Texture2D::setTextureWrap(const GLint wrapX, const GLint wrapY, const GLenum activeTexture) const
     {
+        // the texture is left bound afterwards, so back-to-back parameter changes only bind it once
         use(activeTexture);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapX);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapY);
-
-        unbind();
     }
 
     void Texture2D::setTextureBorder(const std::array<GLfloat, 4>& borderColor, const GLenum activeTexture) const
@@ -101,8 +132,6 @@ namespace LearnOpenGL::Graphics
         use(activeTexture);
 
         glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor.data());
-
-        unbind();
     }
 
     void Texture2D::setTextureFilters(const GLint minifyingFilter, const GLint magnifyingFilter, const GLenum activeTexture) const
@@ -111,13 +140,11 @@ namespace LearnOpenGL::Graphics
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minifyingFilter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magnifyingFilter);
-
-        unbind();
     }
 
     void Texture2D::bind() const
     {
-        glBindTexture(GL_TEXTURE_2D, _textureId);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, _textureId);
     }
 
     Texture2D::~Texture2D()
@@ -127,13 +154,12 @@ namespace LearnOpenGL::Graphics
 
     void Texture2D::stopUsing(const GLenum activeTexture)
     {
-        glActiveTexture(activeTexture);
-        unbind();
+        GLStateCache::bindTexture(activeTexture, GL_TEXTURE_2D, DefaultTexture);
     }
 
     void Texture2D::unbind()
     {
-        glBindTexture(GL_TEXTURE_2D, DefaultTexture);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, DefaultTexture);
     }
 
     void Texture2D::addReference(const unsigned int textureId)
@@ -164,8 +190,11 @@ namespace LearnOpenGL::Graphics
 
         if (_textureReferences[textureId] == 0)
         {
+            UploadScheduler::getShared().cancelTexture(textureId);
             glDeleteTextures(1, &textureId);
             _textureReferences.erase(textureId);
+            GLStateCache::onTextureDeleted(textureId);
+            TextureRegistry::onTextureDeleted(textureId);
         }
     }
 }
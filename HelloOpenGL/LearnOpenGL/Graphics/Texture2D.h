@@ -1,6 +1,7 @@
 ﻿#pragma once
 #ifndef TEXTURE_2D_H
 #define TEXTURE_2D_H
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <glad/glad.h>
@@ -14,10 +15,13 @@ namespace LearnOpenGL::Graphics
     public:
         explicit Texture2D(const std::string& texturePath, bool useMipmaps = false, bool useSRGB = false);
         Texture2D(const Texture2D& other);
-        Texture2D(Texture2D&&) noexcept = default;
+        Texture2D(Texture2D&& other) noexcept;
 
         Texture2D& operator=(const Texture2D& other);
-        Texture2D& operator=(Texture2D&&) = default;
+        Texture2D& operator=(Texture2D&& other) noexcept;
+
+        // Adds a reference to a texture that was created elsewhere, so it is deleted along with its last Texture2D.
+        static Texture2D fromId(unsigned int textureId);
 
         [[nodiscard]] unsigned int getId() const;
 
@@ -37,7 +41,9 @@ namespace LearnOpenGL::Graphics
     private:
         inline static std::pmr::unordered_map<unsigned int, unsigned int> _textureReferences{ {} };
 
-        unsigned int _textureId;
+        unsigned int _textureId{};
+
+        Texture2D() = default;
 
         static void addReference(unsigned int textureId);
         static void removeReference(unsigned int textureId);
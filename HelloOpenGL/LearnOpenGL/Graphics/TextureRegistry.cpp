@@ -0,0 +1,93 @@
+﻿#include "TextureRegistry.h"
+
+#include <filesystem>
+#include <system_error>
+
+namespace LearnOpenGL::Graphics
+{
+    std::string TextureRegistry::canonicalizePath(const std::string& texturePath)
+    {
+        std::error_code error;
+        const std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(texturePath, error);
+
+        return error ? std::filesystem::path(texturePath).lexically_normal().generic_string() : canonicalPath.generic_string();
+    }
+
+    std::optional<Texture2D> TextureRegistry::findByPath(const std::string& canonicalPath)
+    {
+        const auto texture = _texturesByPath.find(canonicalPath);
+
+        if (texture == _texturesByPath.end())
+        {
+            _stats.misses++;
+            return std::nullopt;
+        }
+
+        _stats.hits++;
+        return Texture2D::fromId(texture->second);
+    }
+
+    std::optional<Texture2D> TextureRegistry::findByContent(const std::string& canonicalPath, const uint64_t contentHash)
+    {
+        const auto texture = _texturesByContent.find(contentHash);
+
+        if (texture == _texturesByContent.end())
+        {
+            return std::nullopt;
+        }
+
+        // same pixels under another name: remember the alias so the next lookup skips decoding entirely
+        _texturesByPath.insert({ canonicalPath, texture->second });
+        _entries[texture->second].paths.push_back(canonicalPath);
+
+        _stats.contentHits++;
+        return Texture2D::fromId(texture->second);
+    }
+
+    Texture2D TextureRegistry::add(const std::string& canonicalPath, const uint64_t contentHash, const unsigned int textureId,
+                                   const size_t byteSize)
+    {
+        Texture2D texture = Texture2D::fromId(textureId);
+
+        if (!textureId)
+        {
+            return texture;
+        }
+
+        _texturesByPath.insert({ canonicalPath, textureId });
+        _texturesByContent.insert({ contentHash, textureId });
+        _entries.insert({ textureId, { contentHash, byteSize, { canonicalPath } } });
+
+        _stats.textureCount++;
+        _stats.bytesResident += byteSize;
+
+        return texture;
+    }
+
+    TextureRegistryStats TextureRegistry::getStats()
+    {
+        return _stats;
+    }
+
+    void TextureRegistry::onTextureDeleted(const unsigned int textureId)
+    {
+        const auto entry = _entries.find(textureId);
+
+        if (entry == _entries.end())
+        {
+            return;
+        }
+
+        for (const std::string& path : entry->second.paths)
+        {
+            _texturesByPath.erase(path);
+        }
+
+        _texturesByContent.erase(entry->second.contentHash);
+
+        _stats.textureCount--;
+        _stats.bytesResident -= entry->second.byteSize;
+
+        _entries.erase(entry);
+    }
+}
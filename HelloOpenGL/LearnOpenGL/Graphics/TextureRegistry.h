@@ -0,0 +1,63 @@
+﻿#pragma once
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture2D.h"
+
+namespace LearnOpenGL::Graphics
+{
+    struct TextureRegistryStats
+    {
+        size_t hits;
+        // misses whose decoded file turned out to match an already uploaded texture
+        size_t contentHits;
+        size_t misses;
+        size_t textureCount;
+        size_t bytesResident;
+    };
+
+    // Process-wide lookup of uploaded textures, so models referencing the same file share one GL texture.
+    // Entries do not keep their texture alive: the Texture2D handles given out do, through Texture2D's reference counts,
+    // and an entry is dropped once the last handle to its texture is destroyed.
+    // Only use from the thread owning the GL context.
+    class TextureRegistry
+    {
+    public:
+        static std::string canonicalizePath(const std::string& texturePath);
+
+        // Both lookups count towards the registry stats, and return a new reference on success.
+        static std::optional<Texture2D> findByPath(const std::string& canonicalPath);
+        static std::optional<Texture2D> findByContent(const std::string& canonicalPath, uint64_t contentHash);
+
+        // Takes over a texture that was just uploaded. Returns the first reference to it.
+        static Texture2D add(const std::string& canonicalPath, uint64_t contentHash, unsigned int textureId, size_t byteSize);
+
+        [[nodiscard]] static TextureRegistryStats getStats();
+
+    private:
+        friend class Texture2D;
+
+        struct Entry
+        {
+            uint64_t contentHash;
+            size_t byteSize;
+            std::vector<std::string> paths;
+        };
+
+        inline static std::unordered_map<std::string, unsigned int> _texturesByPath{};
+        inline static std::unordered_map<uint64_t, unsigned int> _texturesByContent{};
+        inline static std::unordered_map<unsigned int, Entry> _entries{};
+        inline static TextureRegistryStats _stats{};
+
+        static void onTextureDeleted(unsigned int textureId);
+    };
+}
+
+#endif // TEXTURE_REGISTRY_H
@@ -0,0 +1,117 @@
+﻿#pragma once
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// C++ mirrors of the std140 uniform blocks declared in the shaders.
+// std140 aligns vec3 to 16 bytes, so every vec3 is followed by either a scalar member or explicit padding.
+// Any change here has to be made to the GLSL declarations as well; the static_asserts below catch layout drift.
+
+namespace LearnOpenGL::Graphics
+{
+    // MAX_POINT_LIGHTS in shader_features.glsl
+    constexpr int MaxPointLights = 16;
+
+    inline constexpr const char* FrameUniformsBlockName = "FrameUniforms";
+    inline constexpr const char* LightUniformsBlockName = "LightUniforms";
+    inline constexpr const char* ClusterUniformsBlockName = "ClusterUniforms";
+
+    struct alignas(16) FrameUniforms
+    {
+        glm::mat4 view{ 1.0f };
+        glm::mat4 projection{ 1.0f };
+        glm::vec3 viewPosition{ 0.0f };
+        float padding0 = 0.0f;
+    };
+
+    struct alignas(16) DirectionalLightData
+    {
+        glm::vec3 ambient{ 0.0f };
+        float padding0 = 0.0f;
+        glm::vec3 diffuse{ 0.0f };
+        float padding1 = 0.0f;
+        glm::vec3 specular{ 0.0f };
+        float padding2 = 0.0f;
+        glm::vec3 direction{ 0.0f };
+        float padding3 = 0.0f;
+    };
+
+    struct alignas(16) SpotLightData
+    {
+        glm::vec3 ambient{ 0.0f };
+        float padding0 = 0.0f;
+        glm::vec3 diffuse{ 0.0f };
+        float padding1 = 0.0f;
+        glm::vec3 specular{ 0.0f };
+        float padding2 = 0.0f;
+        glm::vec3 position{ 0.0f };
+        float padding3 = 0.0f;
+        glm::vec3 direction{ 0.0f };
+        float cutoff = 0.0f;
+        float outerCutoff = 0.0f;
+    };
+
+    struct alignas(16) PointLightData
+    {
+        glm::vec3 ambient{ 0.0f };
+        float padding0 = 0.0f;
+        glm::vec3 diffuse{ 0.0f };
+        float padding1 = 0.0f;
+        glm::vec3 specular{ 0.0f };
+        float padding2 = 0.0f;
+        glm::vec3 position{ 0.0f };
+        // lighting fades out to nothing at this distance
+        float radius = 0.0f;
+    };
+
+    struct alignas(16) LightUniforms
+    {
+        DirectionalLightData directionalLight;
+        SpotLightData spotLight;
+        PointLightData pointLights[MaxPointLights];
+        int pointLightCount = 0;
+    };
+
+    // how clustered_lights.glsl finds a fragment's cluster, see LightClusters
+    struct alignas(16) ClusterUniforms
+    {
+        glm::uvec4 gridSize{ 0u };
+        // clusters per pixel in x and y
+        glm::vec2 tileScale{ 0.0f };
+        // slice = log(view depth) * depthScale + depthBias
+        float depthScale = 0.0f;
+        float depthBias = 0.0f;
+    };
+
+    static_assert(offsetof(FrameUniforms, view) == 0);
+    static_assert(offsetof(FrameUniforms, projection) == 64);
+    static_assert(offsetof(FrameUniforms, viewPosition) == 128);
+    static_assert(sizeof(FrameUniforms) == 144);
+
+    static_assert(offsetof(DirectionalLightData, diffuse) == 16);
+    static_assert(offsetof(DirectionalLightData, specular) == 32);
+    static_assert(offsetof(DirectionalLightData, direction) == 48);
+    static_assert(sizeof(DirectionalLightData) == 64);
+
+    static_assert(offsetof(SpotLightData, position) == 48);
+    static_assert(offsetof(SpotLightData, direction) == 64);
+    static_assert(offsetof(SpotLightData, cutoff) == 76);
+    static_assert(offsetof(SpotLightData, outerCutoff) == 80);
+    static_assert(sizeof(SpotLightData) == 96);
+
+    static_assert(offsetof(PointLightData, position) == 48);
+    static_assert(offsetof(PointLightData, radius) == 60);
+    static_assert(sizeof(PointLightData) == 64);
+
+    static_assert(offsetof(LightUniforms, spotLight) == 64);
+    static_assert(offsetof(LightUniforms, pointLights) == 160);
+    static_assert(offsetof(LightUniforms, pointLightCount) == 160 + 64 * MaxPointLights);
+
+    static_assert(offsetof(ClusterUniforms, tileScale) == 16);
+    static_assert(offsetof(ClusterUniforms, depthScale) == 24);
+    static_assert(sizeof(ClusterUniforms) == 32);
+}
+
+#endif // UNIFORM_BLOCKS_H
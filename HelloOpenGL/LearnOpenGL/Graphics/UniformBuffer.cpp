@@ -0,0 +1,125 @@
+﻿#include "UniformBuffer.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "DynamicRingBuffer.h"
+
+namespace LearnOpenGL::Graphics
+{
+    UniformBuffer::UniformBuffer(const std::string& blockName, const GLsizeiptr size, const bool perFrame)
+        : _bindingPoint(getBindingPoint(blockName)), _size(size), _perFrame(perFrame)
+    {
+        if (_perFrame)
+        {
+            _perFrameData.resize(static_cast<size_t>(_size));
+            return;
+        }
+
+        glGenBuffers(1, &_bufferId);
+
+        if (!_bufferId)
+        {
+            std::cerr << "Failed to generate uniform buffer for block " << blockName << "\n";
+            return;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, _bufferId);
+        glBufferData(GL_UNIFORM_BUFFER, _size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _bufferId);
+    }
+
+    UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept
+        : _bufferId(std::exchange(other._bufferId, 0)), _bindingPoint(other._bindingPoint), _size(other._size),
+          _perFrameData(std::move(other._perFrameData)), _perFrame(other._perFrame)
+    {
+    }
+
+    UniformBuffer& UniformBuffer::operator=(UniformBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            // perFrame blocks only borrow the ring buffer
+            if (!_perFrame)
+            {
+                glDeleteBuffers(1, &_bufferId);
+            }
+
+            _bufferId = std::exchange(other._bufferId, 0);
+            _bindingPoint = other._bindingPoint;
+            _size = other._size;
+            _perFrameData = std::move(other._perFrameData);
+            _perFrame = other._perFrame;
+        }
+
+        return *this;
+    }
+
+    UniformBuffer::~UniformBuffer()
+    {
+        if (_bufferId && !_perFrame)
+        {
+            glDeleteBuffers(1, &_bufferId);
+        }
+    }
+
+    unsigned int UniformBuffer::getId() const
+    {
+        return _bufferId;
+    }
+
+    GLuint UniformBuffer::getBindingPoint() const
+    {
+        return _bindingPoint;
+    }
+
+    GLsizeiptr UniformBuffer::getSize() const
+    {
+        return _size;
+    }
+
+    void UniformBuffer::setData(const void* data, const GLsizeiptr size, const GLintptr offset)
+    {
+        if (offset + size > _size)
+        {
+            std::cerr << "Uniform buffer write of " << size << " bytes at offset " << offset << " exceeds its size of " << _size << "\n";
+            return;
+        }
+
+        if (_perFrame)
+        {
+            std::memcpy(_perFrameData.data() + offset, data, static_cast<size_t>(size));
+
+            DynamicRingBuffer& ringBuffer = DynamicRingBuffer::getShared();
+            const GLintptr ringOffset = ringBuffer.write(_perFrameData, DynamicRingBuffer::getUniformAlignment());
+
+            if (ringOffset >= 0)
+            {
+                _bufferId = ringBuffer.getId();
+                glBindBufferRange(GL_UNIFORM_BUFFER, _bindingPoint, _bufferId, ringOffset, _size);
+            }
+
+            return;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, _bufferId);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    GLuint UniformBuffer::getBindingPoint(const std::string& blockName)
+    {
+        if (const auto bindingPoint = _bindingPoints.find(blockName); bindingPoint != _bindingPoints.end())
+        {
+            return bindingPoint->second;
+        }
+
+        const auto bindingPoint = static_cast<GLuint>(_bindingPoints.size());
+        _bindingPoints.insert({ blockName, bindingPoint });
+
+        return bindingPoint;
+    }
+}
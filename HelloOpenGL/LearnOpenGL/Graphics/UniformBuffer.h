@@ -0,0 +1,56 @@
+﻿#pragma once
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+namespace LearnOpenGL::Graphics
+{
+    class UniformBuffer
+    {
+    public:
+        // perFrame blocks live in the DynamicRingBuffer instead of a buffer of their own, so rewriting them never waits
+        // on draws still reading the old contents. They have to be set again every frame before drawing.
+        UniformBuffer(const std::string& blockName, GLsizeiptr size, bool perFrame = false);
+        UniformBuffer(const UniformBuffer&) = delete;
+        UniformBuffer(UniformBuffer&& other) noexcept;
+
+        UniformBuffer& operator=(const UniformBuffer&) = delete;
+        UniformBuffer& operator=(UniformBuffer&& other) noexcept;
+
+        ~UniformBuffer();
+
+        // For perFrame blocks, the ring buffer they were last written to.
+        [[nodiscard]] unsigned int getId() const;
+        [[nodiscard]] GLuint getBindingPoint() const;
+        [[nodiscard]] GLsizeiptr getSize() const;
+
+        void setData(const void* data, GLsizeiptr size, GLintptr offset = 0);
+
+        template <typename T>
+        void setData(const T& data)
+        {
+            setData(&data, static_cast<GLsizeiptr>(sizeof(T)));
+        }
+
+        // Every block name maps to one binding point for the lifetime of the process,
+        // so any Shader declaring the block shares the same buffer without further setup.
+        static GLuint getBindingPoint(const std::string& blockName);
+
+    private:
+        inline static std::unordered_map<std::string, GLuint> _bindingPoints{};
+
+        unsigned int _bufferId{};
+        GLuint _bindingPoint{};
+        GLsizeiptr _size{};
+        // perFrame blocks keep their contents here, since partial writes still have to copy the whole block
+        std::vector<std::byte> _perFrameData;
+        bool _perFrame = false;
+    };
+}
+
+#endif // UNIFORM_BUFFER_H
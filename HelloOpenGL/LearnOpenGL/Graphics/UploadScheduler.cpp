@@ -0,0 +1,326 @@
+﻿#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "GLStateCache.h"
+
+namespace LearnOpenGL::Graphics
+{
+    UploadScheduler& UploadScheduler::getShared()
+    {
+        static UploadScheduler scheduler;
+        return scheduler;
+    }
+
+    UploadTicket UploadScheduler::uploadBuffer(const GLuint buffer, const size_t offset, std::vector<std::byte> data)
+    {
+        Job job{};
+        job.destination = buffer;
+        job.destinationOffset = offset;
+        job.size = data.size();
+        job.bytes = std::move(data);
+
+        return queue(std::move(job));
+    }
+
+    UploadTicket UploadScheduler::uploadTexture(const GLuint texture, Image image, const bool generateMipmaps)
+    {
+        Job job{};
+        job.destination = texture;
+        job.isTexture = true;
+        job.generateMipmaps = generateMipmaps;
+        job.size = image.getByteSize();
+        job.rowSize = static_cast<size_t>(image.getWidth()) * static_cast<size_t>(image.getChannels());
+
+        switch (image.getChannels())
+        {
+        case 2:
+            job.format = GL_RG;
+            break;
+        case 3:
+            job.format = GL_RGB;
+            break;
+        case 4:
+            job.format = GL_RGBA;
+            break;
+        default:
+            job.format = GL_RED;
+            break;
+        }
+
+        job.image = std::move(image);
+
+        return queue(std::move(job));
+    }
+
+    void UploadScheduler::cancelTexture(const GLuint texture)
+    {
+        std::erase_if(_jobs, [this, texture](const Job& job)
+        {
+            if (!job.isTexture || job.destination != texture)
+            {
+                return false;
+            }
+
+            _queuedBytes -= job.size - job.uploaded;
+            return true;
+        });
+    }
+
+    void UploadScheduler::retargetBuffer(const GLuint from, const GLuint to)
+    {
+        for (Job& job : _jobs)
+        {
+            if (!job.isTexture && job.destination == from)
+            {
+                job.destination = to;
+            }
+        }
+    }
+
+    void UploadScheduler::update()
+    {
+        _bytesThisFrame = 0;
+        _bytesThisFrame += run(_frameBudget);
+    }
+
+    void UploadScheduler::flush()
+    {
+        while (!_jobs.empty())
+        {
+            _bytesThisFrame += run(_frameBudget);
+        }
+    }
+
+    bool UploadScheduler::isComplete(const UploadTicket ticket) const
+    {
+        return _jobs.empty() || _jobs.front().ticket > ticket;
+    }
+
+    UploadTicket UploadScheduler::getLastTicket() const
+    {
+        return _lastTicket;
+    }
+
+    void UploadScheduler::setFrameBudget(const size_t bytes)
+    {
+        _frameBudget = std::max<size_t>(bytes, 1);
+    }
+
+    size_t UploadScheduler::getFrameBudget() const
+    {
+        return _frameBudget;
+    }
+
+    UploadSchedulerStats UploadScheduler::getStats() const
+    {
+        return {
+            _jobs.size(), _queuedBytes, _bytesThisFrame, _completedJobs,
+            _completedJobs == 0 ? 0.0 : _totalLatencyMilliseconds / static_cast<double>(_completedJobs), _maxLatencyMilliseconds
+        };
+    }
+
+    const std::byte* UploadScheduler::Job::getData() const
+    {
+        return isTexture ? reinterpret_cast<const std::byte*>(image.getData()) : bytes.data();
+    }
+
+    UploadTicket UploadScheduler::queue(Job job)
+    {
+        job.ticket = ++_lastTicket;
+        job.queuedAt = std::chrono::steady_clock::now();
+
+        // nothing to copy, but a texture may still want its (empty) mip chain and the ticket has to complete in order
+        if (job.size == 0 || (job.isTexture && job.rowSize == 0))
+        {
+            job.size = 0;
+        }
+
+        _queuedBytes += job.size;
+        _jobs.push_back(std::move(job));
+
+        return _lastTicket;
+    }
+
+    size_t UploadScheduler::run(const size_t budget)
+    {
+        struct Copy
+        {
+            size_t job;
+            size_t stagingOffset;
+            size_t sourceOffset;
+            size_t size;
+        };
+
+        std::vector<Copy> copies;
+        size_t staged = 0;
+
+        // only the last job taken can be left partially uploaded, so finished jobs always form a prefix of the queue
+        for (size_t i = 0; i < _jobs.size() && staged < budget; i++)
+        {
+            const Job& job = _jobs[i];
+            const size_t remaining = job.size - job.uploaded;
+            size_t chunk = std::min(remaining, budget - staged);
+
+            if (job.isTexture && remaining > 0)
+            {
+                size_t rows = chunk / job.rowSize;
+
+                // a row larger than the whole budget still has to go eventually, just alone
+                if (rows == 0)
+                {
+                    if (staged > 0)
+                    {
+                        break;
+                    }
+
+                    rows = 1;
+                }
+
+                chunk = rows * job.rowSize;
+            }
+
+            copies.push_back({ i, staged, job.uploaded, chunk });
+            staged += chunk;
+
+            if (chunk < remaining)
+            {
+                break;
+            }
+        }
+
+        if (copies.empty())
+        {
+            return 0;
+        }
+
+        // empty jobs complete without touching GL
+        if (staged > 0)
+        {
+            StagingBuffer& staging = acquireStagingBuffer(staged);
+            glBindBuffer(GL_COPY_READ_BUFFER, staging.buffer);
+
+            // the fence guarantees the GPU is done with this buffer, so mapping need not wait on anything
+            if (auto* mapped = static_cast<std::byte*>(glMapBufferRange(
+                GL_COPY_READ_BUFFER, 0, static_cast<long long>(staged),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT)))
+            {
+                for (const Copy& copy : copies)
+                {
+                    std::memcpy(mapped + copy.stagingOffset, _jobs[copy.job].getData() + copy.sourceOffset, copy.size);
+                }
+
+                glUnmapBuffer(GL_COPY_READ_BUFFER);
+            }
+            else
+            {
+                for (const Copy& copy : copies)
+                {
+                    glBufferSubData(GL_COPY_READ_BUFFER, static_cast<long long>(copy.stagingOffset), static_cast<long long>(copy.size),
+                                    _jobs[copy.job].getData() + copy.sourceOffset);
+                }
+            }
+
+            bool unpackBufferBound = false;
+
+            for (const Copy& copy : copies)
+            {
+                const Job& job = _jobs[copy.job];
+
+                if (copy.size > 0 && job.isTexture)
+                {
+                    if (!unpackBufferBound)
+                    {
+                        // rows of RGB images are rarely a multiple of 4 bytes
+                        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+                        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                        unpackBufferBound = true;
+                    }
+
+                    GLStateCache::bindTexture(GL_TEXTURE_2D, job.destination);
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(copy.sourceOffset / job.rowSize), job.image.getWidth(),
+                                    static_cast<GLsizei>(copy.size / job.rowSize), job.format, GL_UNSIGNED_BYTE,
+                                    reinterpret_cast<const void*>(copy.stagingOffset));
+                }
+                else if (copy.size > 0)
+                {
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, job.destination);
+                    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<long long>(copy.stagingOffset),
+                                        static_cast<long long>(job.destinationOffset + copy.sourceOffset), static_cast<long long>(copy.size));
+                }
+            }
+
+            if (unpackBufferBound)
+            {
+                // every other texture upload reads from client memory
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+
+            staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        for (const Copy& copy : copies)
+        {
+            _jobs[copy.job].uploaded += copy.size;
+            _queuedBytes -= copy.size;
+        }
+
+        while (!_jobs.empty() && _jobs.front().uploaded == _jobs.front().size)
+        {
+            completeJob(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        return staged;
+    }
+
+    UploadScheduler::StagingBuffer& UploadScheduler::acquireStagingBuffer(const size_t size)
+    {
+        StagingBuffer& staging = _stagingBuffers[_nextStagingBuffer];
+        _nextStagingBuffer = (_nextStagingBuffer + 1) % StagingBufferCount;
+
+        // normally signaled long ago, since the buffer was last used StagingBufferCount frames back
+        if (staging.fence)
+        {
+            if (glClientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_WAIT_FAILED)
+            {
+                std::cerr << "Waiting on an upload staging buffer failed.\n";
+            }
+
+            glDeleteSync(staging.fence);
+            staging.fence = nullptr;
+        }
+
+        if (staging.buffer == 0)
+        {
+            glGenBuffers(1, &staging.buffer);
+        }
+
+        if (staging.capacity < size)
+        {
+            staging.capacity = std::max(size, _frameBudget);
+            glBindBuffer(GL_COPY_READ_BUFFER, staging.buffer);
+            glBufferData(GL_COPY_READ_BUFFER, static_cast<long long>(staging.capacity), nullptr, GL_STREAM_DRAW);
+        }
+
+        return staging;
+    }
+
+    void UploadScheduler::completeJob(const Job& job)
+    {
+        if (job.isTexture && job.generateMipmaps)
+        {
+            GLStateCache::bindTexture(GL_TEXTURE_2D, job.destination);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        const double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.queuedAt).count();
+        _totalLatencyMilliseconds += latency;
+        _maxLatencyMilliseconds = std::max(_maxLatencyMilliseconds, latency);
+        _completedJobs++;
+    }
+}
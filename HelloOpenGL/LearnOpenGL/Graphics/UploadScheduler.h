@@ -0,0 +1,120 @@
+﻿#pragma once
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Image.h"
+
+namespace LearnOpenGL::Graphics
+{
+    // Jobs finish in the order they were queued, so one ticket covers every job queued before it too.
+    using UploadTicket = uint64_t;
+
+    struct UploadSchedulerStats
+    {
+        size_t queuedJobs;
+        size_t queuedBytes;
+        size_t bytesThisFrame;
+        size_t completedJobs;
+        // from queueing a job to handing its last byte to GL
+        double averageLatencyMilliseconds;
+        double maxLatencyMilliseconds;
+    };
+
+    // Streams buffer and texture data to the GPU through a ring of staging buffers (pixel unpack buffers for textures),
+    // handing GL at most a fixed number of bytes per frame so asset streaming never causes frame spikes.
+    // Large jobs are split across frames; textures a row range at a time. Only use from the thread owning the GL context.
+    class UploadScheduler
+    {
+    public:
+        static constexpr size_t StagingBufferCount = 3;
+        static constexpr size_t DefaultFrameBudget = 8 * 1024 * 1024;
+
+        UploadScheduler() = default;
+        UploadScheduler(const UploadScheduler&) = delete;
+        UploadScheduler& operator=(const UploadScheduler&) = delete;
+
+        // Scheduler everything streams through, created on first use.
+        static UploadScheduler& getShared();
+
+        // Copies data into buffer at offset.
+        UploadTicket uploadBuffer(GLuint buffer, size_t offset, std::vector<std::byte> data);
+        // Fills level 0 of a 2D texture whose storage is already allocated with the image's size and format.
+        UploadTicket uploadTexture(GLuint texture, Image image, bool generateMipmaps);
+        // Drops pending uploads into a texture that is about to be deleted.
+        void cancelTexture(GLuint texture);
+        // Sends pending uploads into from to to instead, for a buffer replaced by a copy. The copy has to be issued
+        // before the next update, so it lands ahead of the remaining uploads.
+        void retargetBuffer(GLuint from, GLuint to);
+
+        // Runs queued jobs until this frame's budget is used up. Call once per frame.
+        void update();
+        // Runs every queued job, ignoring the budget.
+        void flush();
+
+        [[nodiscard]] bool isComplete(UploadTicket ticket) const;
+        [[nodiscard]] UploadTicket getLastTicket() const;
+
+        void setFrameBudget(size_t bytes);
+        [[nodiscard]] size_t getFrameBudget() const;
+        [[nodiscard]] UploadSchedulerStats getStats() const;
+
+    private:
+        struct Job
+        {
+            UploadTicket ticket;
+            GLuint destination;
+            // buffer jobs
+            size_t destinationOffset;
+            std::vector<std::byte> bytes;
+            // texture jobs
+            Image image;
+            GLenum format;
+            size_t rowSize;
+            bool generateMipmaps;
+            bool isTexture;
+
+            size_t size;
+            size_t uploaded;
+            std::chrono::steady_clock::time_point queuedAt;
+
+            [[nodiscard]] const std::byte* getData() const;
+        };
+
+        struct StagingBuffer
+        {
+            GLuint buffer{};
+            size_t capacity{};
+            // signaled once the GPU has consumed the copies made from the buffer
+            GLsync fence{};
+        };
+
+        std::deque<Job> _jobs;
+        std::array<StagingBuffer, StagingBufferCount> _stagingBuffers{};
+        size_t _nextStagingBuffer = 0;
+        size_t _frameBudget = DefaultFrameBudget;
+
+        UploadTicket _lastTicket = 0;
+        size_t _queuedBytes = 0;
+        size_t _bytesThisFrame = 0;
+        size_t _completedJobs = 0;
+        double _totalLatencyMilliseconds = 0.0;
+        double _maxLatencyMilliseconds = 0.0;
+
+        UploadTicket queue(Job job);
+        // Stages and issues queued jobs until budget bytes are used up.
+        size_t run(size_t budget);
+        StagingBuffer& acquireStagingBuffer(size_t size);
+        void completeJob(const Job& job);
+    };
+}
+
+#endif // UPLOAD_SCHEDULER_H
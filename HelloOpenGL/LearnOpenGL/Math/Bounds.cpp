@@ -0,0 +1,45 @@
+﻿#include "Bounds.h"
+
+#include <algorithm>
+
+namespace LearnOpenGL::Math
+{
+    BoundingSphere BoundingSphere::transformed(const glm::mat4& transform) const
+    {
+        const float maxScale = std::max({
+            glm::length(glm::vec3(transform[0])),
+            glm::length(glm::vec3(transform[1])),
+            glm::length(glm::vec3(transform[2]))
+        });
+
+        return { glm::vec3(transform * glm::vec4(center, 1.0f)), radius * maxScale };
+    }
+
+    glm::vec3 AABB::getCenter() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 AABB::getExtents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    AABB AABB::transformed(const glm::mat4& transform) const
+    {
+        // the new extents along each axis are the absolute rotated extents summed up (Arvo's method)
+        const glm::vec3 center = glm::vec3(transform * glm::vec4(getCenter(), 1.0f));
+        const glm::vec3 extents = getExtents();
+
+        const glm::vec3 newExtents = glm::abs(glm::vec3(transform[0])) * extents.x
+            + glm::abs(glm::vec3(transform[1])) * extents.y
+            + glm::abs(glm::vec3(transform[2])) * extents.z;
+
+        return { center - newExtents, center + newExtents };
+    }
+
+    AABB AABB::merged(const AABB& other) const
+    {
+        return { glm::min(min, other.min), glm::max(max, other.max) };
+    }
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+
+namespace LearnOpenGL::Math
+{
+    struct BoundingSphere
+    {
+        glm::vec3 center{ 0.0f };
+        float radius = 0.0f;
+
+        // Radius grows by the largest axis scale, so the result still contains the transformed sphere.
+        [[nodiscard]] BoundingSphere transformed(const glm::mat4& transform) const;
+    };
+
+    struct AABB
+    {
+        glm::vec3 min{ 0.0f };
+        glm::vec3 max{ 0.0f };
+
+        [[nodiscard]] glm::vec3 getCenter() const;
+        [[nodiscard]] glm::vec3 getExtents() const;
+
+        // Box around the transformed box, still axis aligned.
+        [[nodiscard]] AABB transformed(const glm::mat4& transform) const;
+        [[nodiscard]] AABB merged(const AABB& other) const;
+    };
+}
+
+#endif // BOUNDS_H
@@ -0,0 +1,80 @@
+﻿#include "Frustum.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace LearnOpenGL::Math
+{
+    Frustum::Frustum()
+    {
+        for (int i = 0; i < PlaneCount; i++)
+        {
+            _normalX[i] = 0.0f;
+            _normalY[i] = 0.0f;
+            _normalZ[i] = 0.0f;
+            _distance[i] = FLT_MAX;
+        }
+    }
+
+    Frustum::Frustum(const glm::mat4& viewProjection)
+        : Frustum()
+    {
+        const glm::vec4 row0{ viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+        const glm::vec4 row1{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+        const glm::vec4 row2{ viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+        const glm::vec4 row3{ viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+        // left, right, bottom, top, near, far
+        const glm::vec4 planes[] = {
+            row3 + row0, row3 - row0,
+            row3 + row1, row3 - row1,
+            row3 + row2, row3 - row2
+        };
+
+        for (int i = 0; i < 6; i++)
+        {
+            // normalized, so plane distances are in world units and comparable against radii
+            const glm::vec4 plane = planes[i] / glm::length(glm::vec3(planes[i]));
+
+            _normalX[i] = plane.x;
+            _normalY[i] = plane.y;
+            _normalZ[i] = plane.z;
+            _distance[i] = plane.w;
+        }
+    }
+
+    bool Frustum::intersects(const BoundingSphere& sphere) const
+    {
+        bool outside = false;
+
+        for (int i = 0; i < PlaneCount; i++)
+        {
+            const float distance = _normalX[i] * sphere.center.x + _normalY[i] * sphere.center.y
+                + _normalZ[i] * sphere.center.z + _distance[i];
+
+            outside |= distance < -sphere.radius;
+        }
+
+        return !outside;
+    }
+
+    bool Frustum::intersects(const AABB& box) const
+    {
+        const glm::vec3 center = box.getCenter();
+        const glm::vec3 extents = box.getExtents();
+
+        bool outside = false;
+
+        for (int i = 0; i < PlaneCount; i++)
+        {
+            const float distance = _normalX[i] * center.x + _normalY[i] * center.y + _normalZ[i] * center.z + _distance[i];
+            // projected half-size of the box onto the plane normal
+            const float radius = std::abs(_normalX[i]) * extents.x + std::abs(_normalY[i]) * extents.y
+                + std::abs(_normalZ[i]) * extents.z;
+
+            outside |= distance < -radius;
+        }
+
+        return !outside;
+    }
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+namespace LearnOpenGL::Math
+{
+    // View frustum as six inward-facing planes, tested against bounding volumes for culling.
+    class Frustum
+    {
+    public:
+        Frustum();
+        // Extracts the planes from a projection * view matrix (Gribb & Hartmann).
+        explicit Frustum(const glm::mat4& viewProjection);
+
+        [[nodiscard]] bool intersects(const BoundingSphere& sphere) const;
+        [[nodiscard]] bool intersects(const AABB& box) const;
+
+    private:
+        // 6 planes padded to 8, so the plane loops have a fixed, vectorizable trip count; padding planes accept everything
+        static constexpr int PlaneCount = 8;
+
+        // planes stored as separate component arrays, so every plane is tested with the same instruction stream
+        alignas(32) float _normalX[PlaneCount];
+        alignas(32) float _normalY[PlaneCount];
+        alignas(32) float _normalZ[PlaneCount];
+        alignas(32) float _distance[PlaneCount];
+    };
+}
+
+#endif // FRUSTUM_H
@@ -13,28 +13,23 @@ namespace LearnOpenGL::Math
           _rotation(glm::vec3(0.0f)),
           _scale(glm::vec3(1.0f)),
           _transformCache(glm::mat4(1.0f)),
+          _normalMatrixCache(glm::mat3(1.0f)),
           _isTransformDirty(false)
     {
     }
 
     glm::mat4 Transform::get()
     {
-        if (_isTransformDirty)
-        {
-            glm::mat4 result(1.0f);
-
-            result = glm::translate(result, _translation);
-            result = glm::scale(result, _scale);
-            result = glm::rotate(result, glm::radians(_rotation.x), Vector3::Right);
-            result = glm::rotate(result, glm::radians(_rotation.y), Vector3::Up);
-            result = glm::rotate(result, glm::radians(_rotation.z), Vector3::Forward);
-
-            _transformCache = result;
-        }
-
+        forceCalculateTransform();
         return _transformCache;
     }
 
+    glm::mat3 Transform::getNormalMatrix()
+    {
+        forceCalculateTransform();
+        return _normalMatrixCache;
+    }
+
     void Transform::translate(const float translationScalar)
     {
         if (translationScalar == 0.0f)
@@ -118,9 +113,16 @@ namespace LearnOpenGL::Math
             result = glm::rotate(result, glm::radians(_rotation.z), Vector3::Forward);
 
             _transformCache = result;
+            _normalMatrixCache = calculateNormalMatrix(result);
+            _isTransformDirty = false;
         }
     }
 
+    glm::mat3 Transform::calculateNormalMatrix(const glm::mat4& transform)
+    {
+        return glm::transpose(glm::inverse(glm::mat3(transform)));
+    }
+
     glm::vec3 Transform::normalizeRotation(glm::vec3& rotation)
     {
         rotation.x = fmodf(rotation.x, 360.0f);
@@ -21,6 +21,8 @@ namespace LearnOpenGL::Math
         Transform& operator=(Transform&&) = default;
 
         [[nodiscard]] glm::mat4 get();
+        // transpose(inverse(mat3(get()))), kept up to date alongside the transform so shaders do not have to invert it
+        [[nodiscard]] glm::mat3 getNormalMatrix();
 
         void translate(float translationScalar);
         void translate(const glm::vec3& translation);
@@ -33,11 +35,14 @@ namespace LearnOpenGL::Math
 
         void forceCalculateTransform();
 
+        static glm::mat3 calculateNormalMatrix(const glm::mat4& transform);
+
     private:
         glm::vec3 _translation;
         glm::vec3 _rotation;
         glm::vec3 _scale;
         glm::mat4 _transformCache;
+        glm::mat3 _normalMatrixCache;
         bool _isTransformDirty;
 
         static glm::vec3 normalizeRotation(glm::vec3& rotation);
@@ -0,0 +1,362 @@
+﻿#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+
+#include "InstanceData.h"
+#include "Vertex.h"
+#include "../Graphics/GLStateCache.h"
+#include "../Graphics/UploadScheduler.h"
+
+namespace LearnOpenGL::Model
+{
+    GeometryAllocation::GeometryAllocation(GeometryAllocation&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    GeometryAllocation& GeometryAllocation::operator=(GeometryAllocation&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+
+            _arena = other._arena;
+            _vertexFormat = other._vertexFormat;
+            _firstVertex = other._firstVertex;
+            _vertexCount = other._vertexCount;
+            _indexByteOffset = other._indexByteOffset;
+            _indexCount = other._indexCount;
+            _indexType = other._indexType;
+
+            other._arena = nullptr;
+        }
+
+        return *this;
+    }
+
+    GeometryAllocation::~GeometryAllocation()
+    {
+        release();
+    }
+
+    bool GeometryAllocation::isValid() const
+    {
+        return _arena != nullptr;
+    }
+
+    VertexFormat GeometryAllocation::getVertexFormat() const
+    {
+        return _vertexFormat;
+    }
+
+    int GeometryAllocation::getBaseVertex() const
+    {
+        return static_cast<int>(_firstVertex);
+    }
+
+    const void* GeometryAllocation::getIndexOffset() const
+    {
+        return reinterpret_cast<const void*>(_indexByteOffset);
+    }
+
+    unsigned int GeometryAllocation::getFirstIndex() const
+    {
+        const size_t indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        return static_cast<unsigned int>(_indexByteOffset / indexSize);
+    }
+
+    int GeometryAllocation::getIndexCount() const
+    {
+        return static_cast<int>(_indexCount);
+    }
+
+    GLenum GeometryAllocation::getIndexType() const
+    {
+        return _indexType;
+    }
+
+    void GeometryAllocation::release()
+    {
+        if (_arena)
+        {
+            _arena->free(*this);
+            _arena = nullptr;
+        }
+    }
+
+    GeometryArena& GeometryArena::getShared()
+    {
+        static GeometryArena arena;
+        return arena;
+    }
+
+    GeometryAllocation GeometryArena::allocate(const VertexFormat format, const void* vertexData, const size_t vertexCount,
+                                               const void* indexData, const size_t indexCount, const GLenum indexType)
+    {
+        Pool& pool = getPool(format);
+
+        const size_t stride = getVertexStride(format);
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        bool resized = false;
+
+        std::optional<size_t> firstVertex = pool.vertices.allocate(vertexCount);
+
+        if (!firstVertex)
+        {
+            const size_t oldCapacity = pool.vertices.getCapacity();
+            const size_t newCapacity = std::max({ oldCapacity * 2, oldCapacity + vertexCount, InitialVertexCapacity });
+
+            resizeBuffer(pool.vertexBuffer, oldCapacity * stride, newCapacity * stride);
+            pool.vertices.grow(newCapacity);
+            firstVertex = pool.vertices.allocate(vertexCount);
+            resized = true;
+        }
+
+        // index offsets have to be a multiple of the index size
+        std::optional<size_t> indexByteOffset = pool.indexBytes.allocate(indexCount * indexSize, indexSize);
+
+        if (!indexByteOffset)
+        {
+            const size_t oldCapacity = pool.indexBytes.getCapacity();
+            const size_t newCapacity = std::max({ oldCapacity * 2, oldCapacity + indexCount * indexSize + indexSize,
+                                                  InitialIndexCapacity });
+
+            resizeBuffer(pool.indexBuffer, oldCapacity, newCapacity);
+            pool.indexBytes.grow(newCapacity);
+            indexByteOffset = pool.indexBytes.allocate(indexCount * indexSize, indexSize);
+            resized = true;
+        }
+
+        if (!firstVertex || !indexByteOffset)
+        {
+            std::cerr << "Geometry arena failed to allocate " << vertexCount << " vertices and " << indexCount << " indices.\n";
+
+            if (firstVertex)
+            {
+                pool.vertices.free(*firstVertex, vertexCount);
+            }
+
+            if (indexByteOffset)
+            {
+                pool.indexBytes.free(*indexByteOffset, indexCount * indexSize);
+            }
+
+            return {};
+        }
+
+        if (pool.vertexArray == 0)
+        {
+            glGenVertexArrays(1, &pool.vertexArray);
+            resized = true;
+        }
+
+        // the VAO still points at the buffers that were just replaced
+        if (resized)
+        {
+            setupVertexArray(pool, format);
+        }
+
+        // streamed in within the upload scheduler's frame budget; the data has to be copied, the caller's may not outlive the upload
+        const auto* vertexBytes = static_cast<const std::byte*>(vertexData);
+        const auto* indexBytes = static_cast<const std::byte*>(indexData);
+        Graphics::UploadScheduler& uploads = Graphics::UploadScheduler::getShared();
+
+        uploads.uploadBuffer(pool.vertexBuffer, *firstVertex * stride, { vertexBytes, vertexBytes + vertexCount * stride });
+        uploads.uploadBuffer(pool.indexBuffer, *indexByteOffset, { indexBytes, indexBytes + indexCount * indexSize });
+
+        pool.allocations++;
+
+        GeometryAllocation allocation;
+        allocation._arena = this;
+        allocation._vertexFormat = format;
+        allocation._firstVertex = *firstVertex;
+        allocation._vertexCount = vertexCount;
+        allocation._indexByteOffset = *indexByteOffset;
+        allocation._indexCount = indexCount;
+        allocation._indexType = indexType;
+
+        return allocation;
+    }
+
+    unsigned int GeometryArena::getVertexArray(const VertexFormat format) const
+    {
+        return getPool(format).vertexArray;
+    }
+
+    void GeometryArena::bindInstanced(const VertexFormat format, const unsigned int instanceBuffer, const size_t offset)
+    {
+        Pool& pool = getPool(format);
+        Graphics::GLStateCache::bindVertexArray(pool.vertexArray);
+
+        if (pool.instanceBuffer == instanceBuffer && pool.instanceOffset == offset)
+        {
+            return;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+        // matrices take one attribute location per column
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            const unsigned int location = InstanceModelLocation + column;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  reinterpret_cast<const void*>(offset + offsetof(InstanceData, model) + sizeof(glm::vec4) * column));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        for (unsigned int column = 0; column < 3; column++)
+        {
+            const unsigned int location = InstanceNormalMatrixLocation + column;
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  reinterpret_cast<const void*>(offset + offsetof(InstanceData, normalMatrix) + sizeof(glm::vec3) * column));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        pool.instanceBuffer = instanceBuffer;
+        pool.instanceOffset = offset;
+    }
+
+    void GeometryArena::bindDrawIndices(const VertexFormat format, const unsigned int drawIndexBuffer)
+    {
+        Pool& pool = getPool(format);
+        Graphics::GLStateCache::bindVertexArray(pool.vertexArray);
+
+        if (pool.drawIndexBuffer == drawIndexBuffer)
+        {
+            return;
+        }
+
+        if (drawIndexBuffer == 0)
+        {
+            glDisableVertexAttribArray(DrawIndexLocation);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, drawIndexBuffer);
+            glVertexAttribIPointer(DrawIndexLocation, 1, GL_INT, sizeof(int), nullptr);
+            glEnableVertexAttribArray(DrawIndexLocation);
+            glVertexAttribDivisor(DrawIndexLocation, 1);
+        }
+
+        pool.drawIndexBuffer = drawIndexBuffer;
+    }
+
+    GeometryArenaStats GeometryArena::getStats() const
+    {
+        GeometryArenaStats stats{};
+
+        for (size_t i = 0; i < _pools.size(); i++)
+        {
+            const Pool& pool = _pools[i];
+            const size_t stride = getVertexStride(static_cast<VertexFormat>(i));
+
+            stats.allocations += pool.allocations;
+            stats.vertexBytesUsed += pool.vertices.getUsed() * stride;
+            stats.vertexBytesCapacity += pool.vertices.getCapacity() * stride;
+            stats.indexBytesUsed += pool.indexBytes.getUsed();
+            stats.indexBytesCapacity += pool.indexBytes.getCapacity();
+        }
+
+        return stats;
+    }
+
+    void GeometryArena::free(const GeometryAllocation& allocation)
+    {
+        Pool& pool = getPool(allocation._vertexFormat);
+        const size_t indexSize = allocation._indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        // the data stays in the buffers until the ranges are handed out again
+        pool.vertices.free(allocation._firstVertex, allocation._vertexCount);
+        pool.indexBytes.free(allocation._indexByteOffset, allocation._indexCount * indexSize);
+        pool.allocations--;
+    }
+
+    GeometryArena::Pool& GeometryArena::getPool(const VertexFormat format)
+    {
+        return _pools[static_cast<size_t>(format)];
+    }
+
+    const GeometryArena::Pool& GeometryArena::getPool(const VertexFormat format) const
+    {
+        return _pools[static_cast<size_t>(format)];
+    }
+
+    size_t GeometryArena::getVertexStride(const VertexFormat format)
+    {
+        return format == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+    }
+
+    void GeometryArena::resizeBuffer(unsigned int& buffer, const size_t oldSize, const size_t newSize)
+    {
+        unsigned int newBuffer;
+        glGenBuffers(1, &newBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<long long>(newSize), nullptr, GL_STATIC_DRAW);
+
+        if (buffer != 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<long long>(oldSize));
+
+            // uploads still queued for the old buffer run after this copy, so they can simply write into the new one
+            Graphics::UploadScheduler::getShared().retargetBuffer(buffer, newBuffer);
+            glDeleteBuffers(1, &buffer);
+        }
+
+        buffer = newBuffer;
+    }
+
+    void GeometryArena::setupVertexArray(const Pool& pool, const VertexFormat format)
+    {
+        Graphics::GLStateCache::bindVertexArray(pool.vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, pool.vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+
+        if (format == VertexFormat::Compact)
+        {
+            // position, 0-1 within the mesh bounds
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), nullptr);
+            glEnableVertexAttribArray(0);
+
+            // normal, octahedral in xy
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex),
+                                  reinterpret_cast<const void*>(offsetof(CompactVertex, normal)));
+            glEnableVertexAttribArray(1);
+
+            // texture
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex),
+                                  reinterpret_cast<const void*>(offsetof(CompactVertex, textureCoordinates)));
+            glEnableVertexAttribArray(2);
+
+            // tangent, octahedral in xy, bitangent sign in w
+            glVertexAttribPointer(TangentLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex),
+                                  reinterpret_cast<const void*>(offsetof(CompactVertex, tangent)));
+            glEnableVertexAttribArray(TangentLocation);
+        }
+        else
+        {
+            // position
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+            glEnableVertexAttribArray(0);
+
+            // normal
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, normal)));
+            glEnableVertexAttribArray(1);
+
+            // texture
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<const void*>(offsetof(Vertex, textureCoordinates)));
+            glEnableVertexAttribArray(2);
+
+            // tangent
+            glVertexAttribPointer(TangentLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<const void*>(offsetof(Vertex, tangent)));
+            glEnableVertexAttribArray(TangentLocation);
+        }
+    }
+}
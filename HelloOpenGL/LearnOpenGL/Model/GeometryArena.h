@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <array>
+#include <cstddef>
+#include <glad/glad.h>
+
+#include "VertexFormat.h"
+#include "../Utilities/FreeListAllocator.h"
+
+namespace LearnOpenGL::Model
+{
+    class GeometryArena;
+
+    struct GeometryArenaStats
+    {
+        size_t allocations;
+        size_t vertexBytesUsed;
+        size_t vertexBytesCapacity;
+        size_t indexBytesUsed;
+        size_t indexBytesCapacity;
+    };
+
+    // A mesh's vertex and index ranges inside the arena. Releases them when destroyed.
+    class GeometryAllocation
+    {
+    public:
+        GeometryAllocation() = default;
+        GeometryAllocation(const GeometryAllocation&) = delete;
+        GeometryAllocation(GeometryAllocation&& other) noexcept;
+
+        GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+        GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+
+        ~GeometryAllocation();
+
+        [[nodiscard]] bool isValid() const;
+        [[nodiscard]] VertexFormat getVertexFormat() const;
+        // for glDrawElementsBaseVertex: indices are relative to the mesh's first vertex
+        [[nodiscard]] int getBaseVertex() const;
+        [[nodiscard]] const void* getIndexOffset() const;
+        // the same offset in indices, as indirect draw commands take it
+        [[nodiscard]] unsigned int getFirstIndex() const;
+        [[nodiscard]] int getIndexCount() const;
+        [[nodiscard]] GLenum getIndexType() const;
+
+    private:
+        friend class GeometryArena;
+
+        GeometryArena* _arena = nullptr;
+        VertexFormat _vertexFormat = VertexFormat::Full;
+        size_t _firstVertex = 0;
+        size_t _vertexCount = 0;
+        size_t _indexByteOffset = 0;
+        size_t _indexCount = 0;
+        GLenum _indexType = GL_UNSIGNED_INT;
+
+        void release();
+    };
+
+    // Sub-allocates every mesh's vertices and indices out of one vertex buffer and one index buffer per vertex format,
+    // each with a single VAO, so drawing different meshes no longer switches vertex arrays or buffers.
+    // Buffers grow by copying into larger ones; freed ranges are reused through a free list.
+    class GeometryArena
+    {
+    public:
+        GeometryArena() = default;
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        // Arena all meshes share, created on first use. Needs a current context for its first allocation.
+        static GeometryArena& getShared();
+
+        // vertexData holds vertexCount vertices of the format's layout, indexData indexCount indices of indexType.
+        // Both are copied and streamed in through the UploadScheduler, so the range is only drawable once that caught up.
+        GeometryAllocation allocate(VertexFormat format, const void* vertexData, size_t vertexCount, const void* indexData,
+                                    size_t indexCount, GLenum indexType);
+
+        [[nodiscard]] unsigned int getVertexArray(VertexFormat format) const;
+
+        // Binds the format's VAO with its per-instance attributes (see InstanceData.h) reading from instanceBuffer at offset.
+        void bindInstanced(VertexFormat format, unsigned int instanceBuffer, size_t offset);
+        // Binds the format's VAO with the per-draw index (DrawIndexLocation) read once per instance from drawIndexBuffer,
+        // so a multi-draw's baseInstance picks each draw's entry. 0 disables the attribute in favor of glVertexAttribI1i.
+        void bindDrawIndices(VertexFormat format, unsigned int drawIndexBuffer);
+
+        [[nodiscard]] GeometryArenaStats getStats() const;
+
+    private:
+        static constexpr size_t InitialVertexCapacity = 1 << 16;
+        static constexpr size_t InitialIndexCapacity = 1 << 20;
+
+        struct Pool
+        {
+            unsigned int vertexArray{};
+            unsigned int vertexBuffer{};
+            unsigned int indexBuffer{};
+            // instance buffer and offset the per-instance attributes currently read from
+            unsigned int instanceBuffer{};
+            size_t instanceOffset{};
+            // buffer the per-draw index attribute currently reads from, 0 while it is disabled
+            unsigned int drawIndexBuffer{};
+            // in vertices, so offsets are base vertices
+            Utilities::FreeListAllocator vertices;
+            // in bytes, since 16- and 32-bit indices share the buffer
+            Utilities::FreeListAllocator indexBytes;
+            size_t allocations = 0;
+        };
+
+        std::array<Pool, 2> _pools;
+
+        friend class GeometryAllocation;
+        void free(const GeometryAllocation& allocation);
+
+        Pool& getPool(VertexFormat format);
+        [[nodiscard]] const Pool& getPool(VertexFormat format) const;
+
+        static size_t getVertexStride(VertexFormat format);
+        static void resizeBuffer(unsigned int& buffer, size_t oldSize, size_t newSize);
+        static void setupVertexArray(const Pool& pool, VertexFormat format);
+    };
+}
+
+#endif
@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#ifndef INSTANCE_DATA_H
+#define INSTANCE_DATA_H
+
+#include <glm/glm.hpp>
+
+namespace LearnOpenGL::Model
+{
+    // Per-instance vertex attributes read by vertex_instanced.glsl; the model matrix takes locations 3-6,
+    // the normal matrix 7-9.
+    struct InstanceData
+    {
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+    };
+
+    constexpr unsigned int InstanceModelLocation = 3;
+    constexpr unsigned int InstanceNormalMatrixLocation = 7;
+}
+
+#endif
@@ -1,43 +1,78 @@
 ﻿#include "Mesh.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <glad/glad.h>
 
 #include "Texture.h"
+#include "../Graphics/GLStateCache.h"
+#include "../Utilities/Hash.h"
 
 namespace LearnOpenGL::Model
 {
-    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures, Material material)
-        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)), material(material)
+    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures, Material material,
+               const VertexFormat vertexFormat)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)), material(material),
+          _vertexFormat(vertexFormat)
     {
-        setupMesh();
+        prepareGeometry();
+        setupBounds();
+        setupTextureUniformNames();
     }
 
     void Mesh::draw(const Graphics::Shader& shader) const
     {
+        bindMaterial(shader);
+        drawGeometry(shader);
+    }
+
+    const Graphics::Shader& Mesh::draw(Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                                       const glm::mat4& transform, const glm::mat3& normalMatrix) const
+    {
+        const Graphics::Shader& shader = variants.get({ scene.features | getShaderFeatures(), scene.pointLights });
+
+        shader.use();
+        shader.setMat4("model", transform);
+        shader.setMat3("normalMatrix", normalMatrix);
+        draw(shader);
+
+        return shader;
+    }
+
+    void Mesh::bindMaterial(const Graphics::Shader& shader) const
+    {
+        shader.setBool("useTextureArrays", usesTextureArrays());
+
+        if (usesTextureArrays())
+        {
+            // layers and rectangles are all that changes between meshes sharing the arrays
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + DiffuseArrayTextureUnit, GL_TEXTURE_2D_ARRAY, diffuseLayer.arrayTexture);
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + SpecularArrayTextureUnit, GL_TEXTURE_2D_ARRAY, specularLayer.arrayTexture);
+            shader.setInt("material.diffuseLayer", diffuseLayer.layer);
+            shader.setInt("material.specularLayer", specularLayer.layer);
+            shader.setVec4("material.diffuseRectangle", diffuseLayer.rectangle);
+            shader.setVec4("material.specularRectangle", specularLayer.rectangle);
+
+            return;
+        }
+
         // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
         for (unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i);
-
-            std::string number;
-            std::string name = textures[i].type;
-            if (name == "diffuse")
-            {
-                number = std::to_string(diffuseNr++);
-            }
-            else if (name == "specular")
-            {
-                number = std::to_string(specularNr++);
-            }
+            shader.setInt(_textureUniformNames[i], static_cast<int>(i));
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + i, GL_TEXTURE_2D, textures[i].id);
+        }
 
-            shader.setInt(std::string("material.").append(name).append(number), i);
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        // textures stay bound between draws, so clear the units a previous mesh used and this one does not
+        for (auto i = static_cast<unsigned int>(textures.size()); i < _textureUnitsInUse; i++)
+        {
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + i, GL_TEXTURE_2D, 0);
         }
 
+        _textureUnitsInUse = static_cast<unsigned int>(textures.size());
+
         if (textures.empty())
         {
             shader.setVec3("material.diffuseColor", material.diffuseColor);
@@ -45,47 +80,241 @@ namespace LearnOpenGL::Model
             shader.setVec3("material.emissionColor", material.emissionColor);
             shader.setFloat("material.shininess", material.shininess);
         }
+    }
 
-        glBindVertexArray(_vao);
-        glDrawElements(GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT, nullptr);
+    void Mesh::drawGeometry(const Graphics::Shader& shader) const
+    {
+        setVertexFormatUniforms(shader);
+        Graphics::GLStateCache::bindVertexArray(getVertexArray());
+        glDrawElementsBaseVertex(GL_TRIANGLES, _geometry.getIndexCount(), _geometry.getIndexType(), _geometry.getIndexOffset(),
+                                 _geometry.getBaseVertex());
+    }
 
-        // unbind all
-        glBindVertexArray(0);
+    void Mesh::drawGeometryInstanced(const Graphics::Shader& shader, const unsigned int instanceBuffer, const size_t instanceOffset,
+                                     const int instanceCount) const
+    {
+        setVertexFormatUniforms(shader);
+        GeometryArena::getShared().bindInstanced(_vertexFormat, instanceBuffer, instanceOffset);
 
-        // unbind textures
-        for (unsigned int i = 0; i < textures.size(); i++)
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, _geometry.getIndexCount(), _geometry.getIndexType(),
+                                          _geometry.getIndexOffset(), instanceCount, _geometry.getBaseVertex());
+    }
+
+    uint64_t Mesh::getMaterialKey() const
+    {
+        uint64_t key = getTextureKey();
+
+        // the layers and rectangles are uniforms set with the material, so meshes sharing arrays still differ by them
+        if (usesTextureArrays())
         {
-            glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, 0);
+            key = Utilities::hashBytes(&diffuseLayer.layer, sizeof(diffuseLayer.layer), key);
+            key = Utilities::hashBytes(&diffuseLayer.rectangle, sizeof(diffuseLayer.rectangle), key);
+            key = Utilities::hashBytes(&specularLayer.layer, sizeof(specularLayer.layer), key);
+            key = Utilities::hashBytes(&specularLayer.rectangle, sizeof(specularLayer.rectangle), key);
         }
+
+        // colors are only uploaded for untextured meshes, so only they tell materials apart
+        if (textures.empty())
+        {
+            key = Utilities::hashBytes(&material, sizeof(Material), key);
+        }
+
+        return key;
     }
 
-    void Mesh::setupMesh()
+    uint64_t Mesh::getTextureKey() const
     {
-        glGenVertexArrays(1, &_vao);
-        glGenBuffers(1, &_vbo);
-        glGenBuffers(1, &_ebo);
+        uint64_t key = Utilities::HashSeed;
+
+        if (usesTextureArrays())
+        {
+            // the layers come from the draw table when batching, so only the arrays themselves set meshes apart
+            key = Utilities::hashBytes(&diffuseLayer.arrayTexture, sizeof(diffuseLayer.arrayTexture), key);
+            return Utilities::hashBytes(&specularLayer.arrayTexture, sizeof(specularLayer.arrayTexture), key);
+        }
+
+        for (const auto& texture : textures)
+        {
+            key = Utilities::hashBytes(&texture.id, sizeof(texture.id), key);
+        }
 
-        glBindVertexArray(_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-        glBufferData(GL_ARRAY_BUFFER, static_cast<long long>(sizeof(Vertex) * vertices.size()), vertices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long long>(sizeof(unsigned int) * indices.size()), indices.data(),
-                     GL_STATIC_DRAW);
+        return key;
+    }
 
-        // position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-        glEnableVertexAttribArray(0);
+    bool Mesh::usesTextureArrays() const
+    {
+        return diffuseLayer.arrayTexture != 0 || specularLayer.arrayTexture != 0;
+    }
 
-        // normal
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, normal)));
-        glEnableVertexAttribArray(1);
+    uint32_t Mesh::getShaderFeatures() const
+    {
+        if (usesTextureArrays())
+        {
+            return Graphics::ShaderFeatureTextureArrays;
+        }
 
-        // texture
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                              reinterpret_cast<const void*>(offsetof(Vertex, textureCoordinates)));
-        glEnableVertexAttribArray(2);
+        // color-only materials skip texture sampling entirely
+        return textures.empty() ? 0 : Graphics::ShaderFeatureTextures2D;
+    }
 
-        glBindVertexArray(0);
+    unsigned int Mesh::getVertexArray() const
+    {
+        return GeometryArena::getShared().getVertexArray(_vertexFormat);
+    }
+
+    VertexFormat Mesh::getVertexFormat() const
+    {
+        return _vertexFormat;
+    }
+
+    const GeometryAllocation& Mesh::getGeometry() const
+    {
+        return _geometry;
+    }
+
+    const VertexQuantization& Mesh::getQuantization() const
+    {
+        return _quantization;
+    }
+
+    size_t Mesh::getVertexBufferSize() const
+    {
+        return _vertexBufferSize;
+    }
+
+    size_t Mesh::getIndexBufferSize() const
+    {
+        return _indexBufferSize;
+    }
+
+    const Math::AABB& Mesh::getBounds() const
+    {
+        return _bounds;
+    }
+
+    const Math::BoundingSphere& Mesh::getBoundingSphere() const
+    {
+        return _boundingSphere;
+    }
+
+    void Mesh::prepareGeometry()
+    {
+        // indices are relative to the mesh's base vertex, so 16 bits cover any mesh of up to 65536 vertices
+        if (vertices.size() <= MaxShortIndexVertices)
+        {
+            _stagedShortIndices.assign(indices.begin(), indices.end());
+            _indexBufferSize = sizeof(uint16_t) * _stagedShortIndices.size();
+        }
+        else
+        {
+            _indexBufferSize = sizeof(unsigned int) * indices.size();
+        }
+
+        if (_vertexFormat == VertexFormat::Compact)
+        {
+            _quantization = calculateQuantization(vertices);
+            _stagedCompactVertices = compressVertices(vertices, _quantization);
+            _vertexBufferSize = sizeof(CompactVertex) * _stagedCompactVertices.size();
+        }
+        else
+        {
+            _vertexBufferSize = sizeof(Vertex) * vertices.size();
+        }
+    }
+
+    void Mesh::upload()
+    {
+        if (_geometry.isValid())
+        {
+            return;
+        }
+
+        const bool shortIndices = vertices.size() <= MaxShortIndexVertices;
+        const void* indexData = shortIndices ? static_cast<const void*>(_stagedShortIndices.data()) : indices.data();
+        const GLenum indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        if (_vertexFormat == VertexFormat::Compact)
+        {
+            _geometry = GeometryArena::getShared().allocate(_vertexFormat, _stagedCompactVertices.data(), _stagedCompactVertices.size(),
+                                                            indexData, indices.size(), indexType);
+        }
+        else
+        {
+            _geometry = GeometryArena::getShared().allocate(_vertexFormat, vertices.data(), vertices.size(), indexData,
+                                                            indices.size(), indexType);
+        }
+
+        // the arena holds its own copy now
+        std::vector<CompactVertex>().swap(_stagedCompactVertices);
+        std::vector<uint16_t>().swap(_stagedShortIndices);
+    }
+
+    bool Mesh::isUploaded() const
+    {
+        return _geometry.isValid();
+    }
+
+    void Mesh::setupBounds()
+    {
+        if (vertices.empty())
+        {
+            return;
+        }
+
+        _bounds = { vertices.front().position, vertices.front().position };
+
+        for (const auto& vertex : vertices)
+        {
+            _bounds.min = glm::min(_bounds.min, vertex.position);
+            _bounds.max = glm::max(_bounds.max, vertex.position);
+        }
+
+        // centered on the box; tighter than the box's own bounding sphere for most meshes
+        float radiusSquared = 0.0f;
+        const glm::vec3 center = _bounds.getCenter();
+
+        for (const auto& vertex : vertices)
+        {
+            const glm::vec3 offset = vertex.position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+
+        _boundingSphere = { center, std::sqrt(radiusSquared) };
+    }
+
+    void Mesh::setVertexFormatUniforms(const Graphics::Shader& shader) const
+    {
+        const bool compact = _vertexFormat == VertexFormat::Compact;
+        shader.setBool("compactVertices", compact);
+
+        if (compact)
+        {
+            shader.setVec3("positionOffset", _quantization.offset);
+            shader.setVec3("positionScale", _quantization.scale * 65535.0f);
+        }
+    }
+
+    void Mesh::setupTextureUniformNames()
+    {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+
+        _textureUniformNames.clear();
+        _textureUniformNames.reserve(textures.size());
+
+        for (const auto& texture : textures)
+        {
+            std::string number;
+            if (texture.type == "diffuse")
+            {
+                number = std::to_string(diffuseNr++);
+            }
+            else if (texture.type == "specular")
+            {
+                number = std::to_string(specularNr++);
+            }
+
+            _textureUniformNames.push_back(std::string("material.").append(texture.type).append(number));
+        }
     }
 }
@@ -3,12 +3,20 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
+#include <glad/glad.h>
 
+#include "GeometryArena.h"
 #include "Material.h"
 #include "Texture.h"
+#include "TextureArrayPacker.h"
 #include "Vertex.h"
+#include "VertexFormat.h"
 #include "../Graphics/Shader.h"
+#include "../Graphics/ShaderVariants.h"
+#include "../Math/Bounds.h"
 
 using LearnOpenGL::Model::Texture;
 
@@ -21,16 +29,82 @@ namespace LearnOpenGL::Model
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
         Material material;
+        unsigned int materialIndex = 0;
+        // Set when the model packs its textures into arrays, which the mesh then samples instead of its textures.
+        TextureArrayLocation diffuseLayer;
+        TextureArrayLocation specularLayer;
+
+        // Meshes with at most this many vertices are drawn with 16-bit indices.
+        static constexpr size_t MaxShortIndexVertices = 65536;
+        // kept clear of the units bindMaterial hands out to the mesh's own textures
+        static constexpr unsigned int DiffuseArrayTextureUnit = 13;
+        static constexpr unsigned int SpecularArrayTextureUnit = 14;
+
+        // Only prepares the geometry for upload, so meshes can be built away from the context thread.
+        Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures, Material material,
+             VertexFormat vertexFormat = VertexFormat::Full);
+        // Copies the geometry into the shared GeometryArena. Needs the context, and has to happen before the first draw.
+        void upload();
+        [[nodiscard]] bool isUploaded() const;
 
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures, Material material);
         void draw(const Graphics::Shader& shader) const;
+        // Draws with the variant built for this mesh's material on top of the scene's features and returns it,
+        // setting the model and normal matrices on it first.
+        const Graphics::Shader& draw(Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                                     const glm::mat4& transform, const glm::mat3& normalMatrix) const;
+
+        // draw() in two halves, so a render queue can bind a material once and draw every mesh sharing it
+        void bindMaterial(const Graphics::Shader& shader) const;
+        void drawGeometry(const Graphics::Shader& shader) const;
+        // Draws instanceCount copies, reading per-instance InstanceData from instanceBuffer starting at instanceOffset.
+        void drawGeometryInstanced(const Graphics::Shader& shader, unsigned int instanceBuffer, size_t instanceOffset,
+                                   int instanceCount) const;
+
+        // Identifies the textures and colors this mesh binds; meshes with equal keys bind identical state.
+        [[nodiscard]] uint64_t getMaterialKey() const;
+        // Same, for the texture bindings alone.
+        [[nodiscard]] uint64_t getTextureKey() const;
+        [[nodiscard]] bool usesTextureArrays() const;
+        // the fewest shader features that still draw this mesh correctly
+        [[nodiscard]] uint32_t getShaderFeatures() const;
+        [[nodiscard]] unsigned int getVertexArray() const;
+        [[nodiscard]] VertexFormat getVertexFormat() const;
+        // where the mesh sits in the arena, for building multi-draw commands
+        [[nodiscard]] const GeometryAllocation& getGeometry() const;
+        [[nodiscard]] const VertexQuantization& getQuantization() const;
+        // bytes the mesh's vertices take up in the arena
+        [[nodiscard]] size_t getVertexBufferSize() const;
+        [[nodiscard]] size_t getIndexBufferSize() const;
+
+        // model-space bounds, computed once from the vertices
+        [[nodiscard]] const Math::AABB& getBounds() const;
+        [[nodiscard]] const Math::BoundingSphere& getBoundingSphere() const;
 
     private:
-        unsigned int _vao{};
-        unsigned int _vbo{};
-        unsigned int _ebo{};
+        // texture units the last drawn mesh left bound
+        inline static unsigned int _textureUnitsInUse = 0;
+
+        // vertices and indices live in the shared GeometryArena
+        GeometryAllocation _geometry;
+        // converted data waiting for upload(), when the format differs from vertices and indices
+        std::vector<CompactVertex> _stagedCompactVertices;
+        std::vector<uint16_t> _stagedShortIndices;
+
+        VertexFormat _vertexFormat;
+        VertexQuantization _quantization{};
+        size_t _vertexBufferSize{};
+        size_t _indexBufferSize{};
+
+        Math::AABB _bounds;
+        Math::BoundingSphere _boundingSphere;
+
+        // "material.diffuse1", "material.specular1", ... built once instead of on every draw
+        std::vector<std::string> _textureUniformNames;
 
-        void setupMesh();
+        void prepareGeometry();
+        void setupBounds();
+        void setupTextureUniformNames();
+        void setVertexFormatUniforms(const Graphics::Shader& shader) const;
     };
 }
 
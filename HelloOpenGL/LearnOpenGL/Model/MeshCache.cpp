@@ -0,0 +1,297 @@
+﻿#include "MeshCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+
+#include "../Utilities/Hash.h"
+
+namespace LearnOpenGL::Model
+{
+    static constexpr char MeshCacheMagic[8] = { 'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H' };
+    static constexpr uint64_t SectionAlignment = 16;
+
+    static uint64_t alignSection(const uint64_t offset)
+    {
+        return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+    }
+
+    MeshCache::MeshCache(const std::string& cachePath, const MeshCacheKey& key)
+        : _file(cachePath)
+    {
+        if (_file.isOpen() && _file.getSize() >= sizeof(MeshCacheHeader))
+        {
+            _header = reinterpret_cast<const MeshCacheHeader*>(_file.getData());
+
+            if (!validate(key))
+            {
+                _header = nullptr;
+            }
+        }
+    }
+
+    bool MeshCache::isValid() const
+    {
+        return _header != nullptr;
+    }
+
+    std::span<const MeshCacheMesh> MeshCache::getMeshes() const
+    {
+        return getSection<MeshCacheMesh>(_header->meshesOffset, _header->meshCount);
+    }
+
+    std::span<const MeshCacheNode> MeshCache::getNodes() const
+    {
+        return getSection<MeshCacheNode>(_header->nodesOffset, _header->nodeCount);
+    }
+
+    std::span<const MeshCacheMaterial> MeshCache::getMaterials() const
+    {
+        return getSection<MeshCacheMaterial>(_header->materialsOffset, _header->materialCount);
+    }
+
+    std::span<const MeshCacheTexture> MeshCache::getTextures() const
+    {
+        return getSection<MeshCacheTexture>(_header->texturesOffset, _header->textureCount);
+    }
+
+    std::span<const Vertex> MeshCache::getVertices() const
+    {
+        return getSection<Vertex>(_header->verticesOffset, _header->vertexCount);
+    }
+
+    std::span<const unsigned int> MeshCache::getIndices() const
+    {
+        return getSection<unsigned int>(_header->indicesOffset, _header->indexCount);
+    }
+
+    std::span<const MeshCacheDependency> MeshCache::getDependencies() const
+    {
+        return getSection<MeshCacheDependency>(_header->dependenciesOffset, _header->dependencyCount);
+    }
+
+    std::string_view MeshCache::getString(const uint32_t offset, const uint32_t length) const
+    {
+        return { reinterpret_cast<const char*>(_file.getData() + _header->stringsOffset + offset), length };
+    }
+
+    std::string MeshCache::getCachePath(const std::string& modelPath)
+    {
+        return modelPath + ".meshcache";
+    }
+
+    bool MeshCache::validate(const MeshCacheKey& key) const
+    {
+        if (std::memcmp(_header->magic, MeshCacheMagic, sizeof(MeshCacheMagic)) != 0
+            || _header->version != MeshCacheVersion
+            || _header->vertexStride != sizeof(Vertex)
+            || _header->sourceHash != key.sourceHash
+            || _header->importFlags != key.importFlags
+            || _header->processingFlags != key.processingFlags)
+        {
+            return false;
+        }
+
+        const uint64_t fileSize = _file.getSize();
+        const auto sectionFits = [fileSize](const uint64_t offset, const uint64_t count, const uint64_t stride)
+        {
+            return offset % SectionAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / stride;
+        };
+
+        if (!sectionFits(_header->meshesOffset, _header->meshCount, sizeof(MeshCacheMesh))
+            || !sectionFits(_header->nodesOffset, _header->nodeCount, sizeof(MeshCacheNode))
+            || !sectionFits(_header->materialsOffset, _header->materialCount, sizeof(MeshCacheMaterial))
+            || !sectionFits(_header->texturesOffset, _header->textureCount, sizeof(MeshCacheTexture))
+            || !sectionFits(_header->verticesOffset, _header->vertexCount, sizeof(Vertex))
+            || !sectionFits(_header->indicesOffset, _header->indexCount, sizeof(unsigned int))
+            || !sectionFits(_header->stringsOffset, _header->stringBytes, 1)
+            || !sectionFits(_header->dependenciesOffset, _header->dependencyCount, sizeof(MeshCacheDependency)))
+        {
+            return false;
+        }
+
+        // references between sections have to stay in bounds too, so a damaged file can never be read past its end
+        for (const MeshCacheMesh& mesh : getMeshes())
+        {
+            if (mesh.firstVertex + mesh.vertexCount > _header->vertexCount
+                || mesh.firstIndex + mesh.indexCount > _header->indexCount
+                || mesh.materialIndex >= _header->materialCount)
+            {
+                return false;
+            }
+        }
+
+        for (const MeshCacheNode& node : getNodes())
+        {
+            if (static_cast<uint64_t>(node.firstMesh) + node.meshCount > _header->meshCount)
+            {
+                return false;
+            }
+        }
+
+        for (const MeshCacheMaterial& material : getMaterials())
+        {
+            if (static_cast<uint64_t>(material.firstTexture) + material.textureCount > _header->textureCount)
+            {
+                return false;
+            }
+        }
+
+        for (const MeshCacheTexture& texture : getTextures())
+        {
+            if (static_cast<uint64_t>(texture.typeOffset) + texture.typeLength > _header->stringBytes
+                || static_cast<uint64_t>(texture.pathOffset) + texture.pathLength > _header->stringBytes)
+            {
+                return false;
+            }
+        }
+
+        // the key only covers the model file, so materials and texture paths from its other files are checked here
+        for (const MeshCacheDependency& dependency : getDependencies())
+        {
+            if (static_cast<uint64_t>(dependency.pathOffset) + dependency.pathLength > _header->stringBytes)
+            {
+                return false;
+            }
+
+            const std::optional<uint64_t> hash = Utilities::hashFile(std::string(getString(dependency.pathOffset, dependency.pathLength)));
+
+            if (!hash || *hash != dependency.hash)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool MeshCache::write(const std::string& cachePath, const MeshCacheKey& key, const std::vector<Mesh>& meshes,
+                          const std::vector<MeshCacheNode>& nodes, const std::vector<std::string>& dependencyPaths)
+    {
+        std::vector<MeshCacheMesh> meshRecords;
+        std::vector<MeshCacheMaterial> materialRecords;
+        std::vector<MeshCacheTexture> textureRecords;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::string strings;
+
+        std::unordered_map<unsigned int, uint32_t> materialSlots;
+
+        const auto addString = [&strings](const std::string& string)
+        {
+            const auto offset = static_cast<uint32_t>(strings.size());
+            strings.append(string);
+
+            return offset;
+        };
+
+        for (const Mesh& mesh : meshes)
+        {
+            auto materialSlot = materialSlots.find(mesh.materialIndex);
+
+            if (materialSlot == materialSlots.end())
+            {
+                MeshCacheMaterial material{ mesh.material, static_cast<uint32_t>(textureRecords.size()),
+                                            static_cast<uint32_t>(mesh.textures.size()) };
+
+                for (const Texture& texture : mesh.textures)
+                {
+                    const uint32_t typeOffset = addString(texture.type);
+                    const uint32_t pathOffset = addString(texture.path);
+                    textureRecords.push_back({ typeOffset, static_cast<uint32_t>(texture.type.size()), pathOffset,
+                                               static_cast<uint32_t>(texture.path.size()) });
+                }
+
+                materialSlot = materialSlots.insert({ mesh.materialIndex, static_cast<uint32_t>(materialRecords.size()) }).first;
+                materialRecords.push_back(material);
+            }
+
+            meshRecords.push_back({ vertices.size(), indices.size(), static_cast<uint32_t>(mesh.vertices.size()),
+                                    static_cast<uint32_t>(mesh.indices.size()), materialSlot->second, 0 });
+
+            vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+
+        std::vector<MeshCacheDependency> dependencyRecords;
+
+        for (const std::string& dependencyPath : dependencyPaths)
+        {
+            const std::optional<uint64_t> hash = Utilities::hashFile(dependencyPath);
+
+            if (!hash)
+            {
+                std::cerr << "Unable to hash " << dependencyPath << ", not writing mesh cache at " << cachePath << ".\n";
+                return false;
+            }
+
+            const uint32_t pathOffset = addString(dependencyPath);
+            dependencyRecords.push_back({ *hash, pathOffset, static_cast<uint32_t>(dependencyPath.size()) });
+        }
+
+        MeshCacheHeader header{};
+        std::memcpy(header.magic, MeshCacheMagic, sizeof(MeshCacheMagic));
+        header.version = MeshCacheVersion;
+        header.importFlags = key.importFlags;
+        header.processingFlags = key.processingFlags;
+        header.sourceHash = key.sourceHash;
+        header.vertexStride = sizeof(Vertex);
+        header.meshCount = static_cast<uint32_t>(meshRecords.size());
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+        header.materialCount = static_cast<uint32_t>(materialRecords.size());
+        header.textureCount = static_cast<uint32_t>(textureRecords.size());
+        header.stringBytes = static_cast<uint32_t>(strings.size());
+        header.dependencyCount = static_cast<uint32_t>(dependencyRecords.size());
+        header.vertexCount = vertices.size();
+        header.indexCount = indices.size();
+
+        header.meshesOffset = alignSection(sizeof(MeshCacheHeader));
+        header.nodesOffset = alignSection(header.meshesOffset + meshRecords.size() * sizeof(MeshCacheMesh));
+        header.materialsOffset = alignSection(header.nodesOffset + nodes.size() * sizeof(MeshCacheNode));
+        header.texturesOffset = alignSection(header.materialsOffset + materialRecords.size() * sizeof(MeshCacheMaterial));
+        header.verticesOffset = alignSection(header.texturesOffset + textureRecords.size() * sizeof(MeshCacheTexture));
+        header.indicesOffset = alignSection(header.verticesOffset + vertices.size() * sizeof(Vertex));
+        header.stringsOffset = alignSection(header.indicesOffset + indices.size() * sizeof(unsigned int));
+        header.dependenciesOffset = alignSection(header.stringsOffset + strings.size());
+
+        std::vector<unsigned char> contents(header.dependenciesOffset + dependencyRecords.size() * sizeof(MeshCacheDependency));
+
+        const auto writeSection = [&contents](const uint64_t offset, const void* data, const size_t size)
+        {
+            if (size > 0)
+            {
+                std::memcpy(contents.data() + offset, data, size);
+            }
+        };
+
+        writeSection(0, &header, sizeof(header));
+        writeSection(header.meshesOffset, meshRecords.data(), meshRecords.size() * sizeof(MeshCacheMesh));
+        writeSection(header.nodesOffset, nodes.data(), nodes.size() * sizeof(MeshCacheNode));
+        writeSection(header.materialsOffset, materialRecords.data(), materialRecords.size() * sizeof(MeshCacheMaterial));
+        writeSection(header.texturesOffset, textureRecords.data(), textureRecords.size() * sizeof(MeshCacheTexture));
+        writeSection(header.verticesOffset, vertices.data(), vertices.size() * sizeof(Vertex));
+        writeSection(header.indicesOffset, indices.data(), indices.size() * sizeof(unsigned int));
+        writeSection(header.stringsOffset, strings.data(), strings.size());
+        writeSection(header.dependenciesOffset, dependencyRecords.data(), dependencyRecords.size() * sizeof(MeshCacheDependency));
+
+        std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            std::cerr << "Unable to open mesh cache at " << cachePath << " for writing.\n";
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+
+        if (!file)
+        {
+            std::cerr << "Error while writing mesh cache at " << cachePath << ".\n";
+            return false;
+        }
+
+        return true;
+    }
+}
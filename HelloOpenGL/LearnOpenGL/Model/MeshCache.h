@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Material.h"
+#include "Mesh.h"
+#include "Vertex.h"
+#include "../Utilities/MappedFile.h"
+
+namespace LearnOpenGL::Model
+{
+    // Bump whenever any of the records below, Vertex, or the mesh processing in Model changes.
+    constexpr uint32_t MeshCacheVersion = 5;
+
+    // Post-import processing baked into the cached meshes, part of the cache key.
+    constexpr uint32_t MeshProcessingOptimized = 1u << 0;
+
+    struct MeshCacheKey
+    {
+        uint64_t sourceHash;
+        uint32_t importFlags;
+        uint32_t processingFlags;
+    };
+
+    // All records are plain data read straight out of the mapped file, with every section aligned to 16 bytes.
+    struct MeshCacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t importFlags;
+        uint64_t sourceHash;
+        uint32_t vertexStride;
+        uint32_t meshCount;
+        uint32_t nodeCount;
+        uint32_t materialCount;
+        uint32_t textureCount;
+        uint32_t stringBytes;
+        uint32_t processingFlags;
+        uint32_t dependencyCount;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t meshesOffset;
+        uint64_t nodesOffset;
+        uint64_t materialsOffset;
+        uint64_t texturesOffset;
+        uint64_t verticesOffset;
+        uint64_t indicesOffset;
+        uint64_t stringsOffset;
+        uint64_t dependenciesOffset;
+    };
+
+    struct MeshCacheMesh
+    {
+        uint64_t firstVertex;
+        uint64_t firstIndex;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t materialIndex;
+        uint32_t padding;
+    };
+
+    struct MeshCacheNode
+    {
+        int32_t parent;
+        uint32_t firstMesh;
+        uint32_t meshCount;
+    };
+
+    struct MeshCacheMaterial
+    {
+        Material material;
+        uint32_t firstTexture;
+        uint32_t textureCount;
+    };
+
+    struct MeshCacheTexture
+    {
+        uint32_t typeOffset;
+        uint32_t typeLength;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    // A file other than the model itself that the import read, such as an .obj's .mtl. The cache is stale once its hash changes.
+    struct MeshCacheDependency
+    {
+        uint64_t hash;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    class MeshCache
+    {
+    public:
+        // Maps the cache file and validates it against the key. Missing, stale and corrupt caches are all reported through isValid().
+        MeshCache(const std::string& cachePath, const MeshCacheKey& key);
+
+        [[nodiscard]] bool isValid() const;
+
+        [[nodiscard]] std::span<const MeshCacheMesh> getMeshes() const;
+        [[nodiscard]] std::span<const MeshCacheNode> getNodes() const;
+        [[nodiscard]] std::span<const MeshCacheMaterial> getMaterials() const;
+        [[nodiscard]] std::span<const MeshCacheTexture> getTextures() const;
+        [[nodiscard]] std::span<const Vertex> getVertices() const;
+        [[nodiscard]] std::span<const unsigned int> getIndices() const;
+        [[nodiscard]] std::span<const MeshCacheDependency> getDependencies() const;
+        [[nodiscard]] std::string_view getString(uint32_t offset, uint32_t length) const;
+
+        static std::string getCachePath(const std::string& modelPath);
+        // dependencyPaths are hashed while writing, so they should be the files the import just read
+        static bool write(const std::string& cachePath, const MeshCacheKey& key, const std::vector<Mesh>& meshes,
+                          const std::vector<MeshCacheNode>& nodes, const std::vector<std::string>& dependencyPaths);
+
+    private:
+        Utilities::MappedFile _file;
+        const MeshCacheHeader* _header{};
+
+        bool validate(const MeshCacheKey& key) const;
+
+        template <typename T>
+        std::span<const T> getSection(uint64_t offset, uint64_t count) const
+        {
+            return { reinterpret_cast<const T*>(_file.getData() + offset), static_cast<size_t>(count) };
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,517 @@
+﻿#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <numeric>
+
+namespace LearnOpenGL::Model
+{
+    namespace
+    {
+        // tuning values from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+        constexpr int ForsythCacheSize = 32;
+        constexpr float CacheDecayPower = 1.5f;
+        constexpr float LastTriangleScore = 0.75f;
+        constexpr float ValenceBoostScale = 2.0f;
+        constexpr float ValenceBoostPower = 0.5f;
+
+        constexpr size_t NoTriangle = SIZE_MAX;
+
+        float calculateVertexScore(const int cachePosition, const unsigned int activeTriangles)
+        {
+            if (activeTriangles == 0)
+            {
+                // nothing left to draw with it
+                return -1.0f;
+            }
+
+            float score = 0.0f;
+
+            if (cachePosition >= 0)
+            {
+                // the last triangle's vertices get a fixed score, so the next triangle doesn't strongly prefer reusing its edge
+                if (cachePosition < 3)
+                {
+                    score = LastTriangleScore;
+                }
+                else
+                {
+                    constexpr float scaler = 1.0f / (ForsythCacheSize - 3);
+                    score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, CacheDecayPower);
+                }
+            }
+
+            // favor vertices with few triangles left, so they get finished off instead of left stranded
+            score += ValenceBoostScale * std::pow(static_cast<float>(activeTriangles), -ValenceBoostPower);
+            return score;
+        }
+
+        // FIFO cache simulated with timestamps: a vertex is cached if it was transformed less than cacheSize misses ago.
+        class FifoCache
+        {
+        public:
+            FifoCache(const size_t vertexCount, const unsigned int cacheSize)
+                : _timestamps(vertexCount, 0), _time(cacheSize + 1), _cacheSize(cacheSize)
+            {
+            }
+
+            // returns true on a miss
+            bool access(const unsigned int vertex)
+            {
+                if (_time - _timestamps[vertex] > _cacheSize)
+                {
+                    _timestamps[vertex] = _time++;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void flush()
+            {
+                _time += _cacheSize + 1;
+            }
+
+        private:
+            std::vector<unsigned int> _timestamps;
+            unsigned int _time;
+            unsigned int _cacheSize;
+        };
+    }
+
+    float VertexCacheStats::getAcmr() const
+    {
+        return triangles == 0 ? 0.0f : static_cast<float>(transformedVertices) / static_cast<float>(triangles);
+    }
+
+    float VertexCacheStats::getAtvr() const
+    {
+        return vertices == 0 ? 0.0f : static_cast<float>(transformedVertices) / static_cast<float>(vertices);
+    }
+
+    VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other)
+    {
+        triangles += other.triangles;
+        vertices += other.vertices;
+        transformedVertices += other.transformedVertices;
+        return *this;
+    }
+
+    VertexCacheStats analyzeVertexCache(const std::span<const unsigned int> indices, const size_t vertexCount,
+                                        const unsigned int cacheSize)
+    {
+        VertexCacheStats stats{ indices.size() / 3, 0, 0 };
+
+        FifoCache cache{ vertexCount, cacheSize };
+        std::vector<bool> referenced(vertexCount, false);
+
+        for (const unsigned int index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                stats.vertices++;
+            }
+
+            if (cache.access(index))
+            {
+                stats.transformedVertices++;
+            }
+        }
+
+        return stats;
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int>& indices, const size_t vertexCount)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // triangles using each vertex; the first activeTriangles[v] entries of a vertex's range are not yet emitted
+        std::vector<unsigned int> activeTriangles(vertexCount, 0);
+        std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::vector<size_t> adjacency(indices.size());
+
+        for (const unsigned int index : indices)
+        {
+            activeTriangles[index]++;
+        }
+
+        for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + activeTriangles[vertex];
+        }
+
+        {
+            std::vector<size_t> fillCursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+            for (size_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    adjacency[fillCursor[indices[triangle * 3 + corner]]++] = triangle;
+                }
+            }
+        }
+
+        std::vector<int> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+
+        for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            vertexScores[vertex] = calculateVertexScore(-1, activeTriangles[vertex]);
+        }
+
+        const auto scoreTriangle = [&](const size_t triangle)
+        {
+            return vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]]
+                + vertexScores[indices[triangle * 3 + 2]];
+        };
+
+        size_t bestTriangle = 0;
+
+        for (size_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            triangleScores[triangle] = scoreTriangle(triangle);
+
+            if (triangleScores[triangle] > triangleScores[bestTriangle])
+            {
+                bestTriangle = triangle;
+            }
+        }
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+
+        // room for the cache plus the three vertices a triangle can push past its end
+        std::array<unsigned int, ForsythCacheSize + 3> cache{};
+        std::array<unsigned int, ForsythCacheSize + 3> newCache{};
+        size_t cacheCount = 0;
+        size_t scanCursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            if (bestTriangle == NoTriangle)
+            {
+                // nothing in the cache has triangles left; restart from the next triangle not yet emitted
+                while (emitted[scanCursor])
+                {
+                    scanCursor++;
+                }
+
+                bestTriangle = scanCursor;
+            }
+
+            emitted[bestTriangle] = true;
+            size_t newCacheCount = 0;
+
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const unsigned int vertex = indices[bestTriangle * 3 + corner];
+                result.push_back(vertex);
+                newCache[newCacheCount++] = vertex;
+
+                // swap the triangle out of the vertex's active range
+                const size_t begin = adjacencyOffsets[vertex];
+                const size_t end = begin + activeTriangles[vertex];
+                const auto found = std::find(adjacency.begin() + static_cast<long long>(begin),
+                                             adjacency.begin() + static_cast<long long>(end), bestTriangle);
+                std::iter_swap(found, adjacency.begin() + static_cast<long long>(end - 1));
+                activeTriangles[vertex]--;
+            }
+
+            for (size_t i = 0; i < cacheCount; i++)
+            {
+                const unsigned int vertex = cache[i];
+
+                if (vertex != newCache[0] && vertex != newCache[1] && vertex != newCache[2])
+                {
+                    newCache[newCacheCount++] = vertex;
+                }
+            }
+
+            for (size_t i = 0; i < newCacheCount; i++)
+            {
+                const unsigned int vertex = newCache[i];
+                cachePositions[vertex] = i < ForsythCacheSize ? static_cast<int>(i) : -1;
+                vertexScores[vertex] = calculateVertexScore(cachePositions[vertex], activeTriangles[vertex]);
+            }
+
+            // only triangles touching a vertex whose score just changed can have a new score
+            bestTriangle = NoTriangle;
+            float bestScore = -1.0f;
+
+            for (size_t i = 0; i < newCacheCount; i++)
+            {
+                const unsigned int vertex = newCache[i];
+                const size_t begin = adjacencyOffsets[vertex];
+
+                for (size_t j = begin; j < begin + activeTriangles[vertex]; j++)
+                {
+                    const size_t triangle = adjacency[j];
+                    triangleScores[triangle] = scoreTriangle(triangle);
+
+                    if (triangleScores[triangle] > bestScore)
+                    {
+                        bestScore = triangleScores[triangle];
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCacheCount, static_cast<size_t>(ForsythCacheSize));
+            std::copy_n(newCache.begin(), cacheCount, cache.begin());
+        }
+
+        indices = std::move(result);
+    }
+
+    void optimizeOverdraw(std::vector<unsigned int>& indices, const std::span<const Vertex> vertices, const float threshold)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount < 2)
+        {
+            return;
+        }
+
+        // hard boundaries: triangles where all three vertices missed, so the cache effectively started over and
+        // reordering there costs nothing
+        std::vector<size_t> hardClusters;
+        {
+            FifoCache cache{ vertices.size(), VertexCacheSize };
+
+            for (size_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                const int misses = cache.access(indices[triangle * 3]) + cache.access(indices[triangle * 3 + 1])
+                    + cache.access(indices[triangle * 3 + 2]);
+
+                if (triangle == 0 || misses == 3)
+                {
+                    hardClusters.push_back(triangle);
+                }
+            }
+
+            hardClusters.push_back(triangleCount);
+        }
+
+        // soft boundaries split hard clusters further, wherever starting over keeps the ACMR within threshold
+        std::vector<size_t> clusters;
+        {
+            FifoCache cache{ vertices.size(), VertexCacheSize };
+
+            for (size_t hard = 0; hard + 1 < hardClusters.size(); hard++)
+            {
+                const size_t begin = hardClusters[hard];
+                const size_t end = hardClusters[hard + 1];
+
+                cache.flush();
+                size_t clusterMisses = 0;
+
+                for (size_t triangle = begin; triangle < end; triangle++)
+                {
+                    clusterMisses += cache.access(indices[triangle * 3]) + cache.access(indices[triangle * 3 + 1])
+                        + cache.access(indices[triangle * 3 + 2]);
+                }
+
+                const float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+                cache.flush();
+                clusters.push_back(begin);
+
+                size_t softStart = begin;
+                size_t softMisses = 0;
+
+                for (size_t triangle = begin; triangle < end; triangle++)
+                {
+                    softMisses += cache.access(indices[triangle * 3]) + cache.access(indices[triangle * 3 + 1])
+                        + cache.access(indices[triangle * 3 + 2]);
+
+                    const float softAcmr = static_cast<float>(softMisses) / static_cast<float>(triangle + 1 - softStart);
+
+                    if (triangle + 1 < end && softAcmr <= clusterAcmr * threshold)
+                    {
+                        clusters.push_back(triangle + 1);
+                        softStart = triangle + 1;
+                        softMisses = 0;
+                        cache.flush();
+                    }
+                }
+            }
+
+            clusters.push_back(triangleCount);
+        }
+
+        const size_t clusterCount = clusters.size() - 1;
+
+        if (clusterCount < 2)
+        {
+            return;
+        }
+
+        glm::vec3 meshCentroid{ 0.0f };
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+        float meshArea = 0.0f;
+
+        for (size_t cluster = 0; cluster < clusterCount; cluster++)
+        {
+            float clusterArea = 0.0f;
+
+            for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++)
+            {
+                const glm::vec3& a = vertices[indices[triangle * 3]].position;
+                const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+                const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+
+                // the cross product's length is twice the area; the factor cancels out
+                const glm::vec3 normal = glm::cross(b - a, c - a);
+                const float area = glm::length(normal);
+                const glm::vec3 centroid = (a + b + c) / 3.0f;
+
+                clusterCentroids[cluster] += centroid * area;
+                clusterNormals[cluster] += normal;
+                meshCentroid += centroid * area;
+                clusterArea += area;
+            }
+
+            meshArea += clusterArea;
+
+            if (clusterArea > 0.0f)
+            {
+                clusterCentroids[cluster] /= clusterArea;
+            }
+        }
+
+        if (meshArea > 0.0f)
+        {
+            meshCentroid /= meshArea;
+        }
+
+        // clusters facing away from the mesh center tend to occlude the rest, so they go first
+        std::vector<float> sortKeys(clusterCount);
+
+        for (size_t cluster = 0; cluster < clusterCount; cluster++)
+        {
+            const float normalLength = glm::length(clusterNormals[cluster]);
+            sortKeys[cluster] = normalLength > 0.0f
+                                    ? glm::dot(clusterCentroids[cluster] - meshCentroid, clusterNormals[cluster] / normalLength)
+                                    : 0.0f;
+        }
+
+        std::vector<size_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](const size_t a, const size_t b)
+        {
+            return sortKeys[a] > sortKeys[b];
+        });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+
+        for (const size_t cluster : order)
+        {
+            result.insert(result.end(), indices.begin() + static_cast<long long>(clusters[cluster] * 3),
+                          indices.begin() + static_cast<long long>(clusters[cluster + 1] * 3));
+        }
+
+        indices = std::move(result);
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == UINT_MAX)
+            {
+                remap[index] = static_cast<unsigned int>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        vertices = std::move(reordered);
+    }
+
+    std::vector<MeshPart> splitMesh(const std::span<const Vertex> vertices, const std::span<const unsigned int> indices,
+                                    const size_t maxVertices)
+    {
+        std::vector<MeshPart> parts;
+        std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+        // vertices the current part has remapped, to reset when it is full
+        std::vector<unsigned int> partVertices;
+
+        MeshPart part;
+
+        for (size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+        {
+            const unsigned int* corners = &indices[triangle * 3];
+
+            size_t newVertices = 0;
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const bool repeated = (corner > 0 && corners[corner] == corners[0]) || (corner > 1 && corners[corner] == corners[1]);
+                newVertices += remap[corners[corner]] == UINT_MAX && !repeated;
+            }
+
+            if (part.vertices.size() + newVertices > maxVertices)
+            {
+                for (const unsigned int vertex : partVertices)
+                {
+                    remap[vertex] = UINT_MAX;
+                }
+
+                partVertices.clear();
+                parts.push_back(std::move(part));
+                part = {};
+            }
+
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const unsigned int vertex = corners[corner];
+
+                if (remap[vertex] == UINT_MAX)
+                {
+                    remap[vertex] = static_cast<unsigned int>(part.vertices.size());
+                    part.vertices.push_back(vertices[vertex]);
+                    partVertices.push_back(vertex);
+                }
+
+                part.indices.push_back(remap[vertex]);
+            }
+        }
+
+        if (!part.indices.empty())
+        {
+            parts.push_back(std::move(part));
+        }
+
+        return parts;
+    }
+
+    MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        MeshOptimizationStats stats{};
+        stats.before = analyzeVertexCache(indices, vertices.size());
+
+        optimizeVertexCache(indices, vertices.size());
+        optimizeOverdraw(indices, vertices);
+        optimizeVertexFetch(vertices, indices);
+
+        stats.after = analyzeVertexCache(indices, vertices.size());
+        return stats;
+    }
+}
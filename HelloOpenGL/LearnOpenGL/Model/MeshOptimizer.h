@@ -0,0 +1,64 @@
+﻿#pragma once
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Vertex.h"
+
+namespace LearnOpenGL::Model
+{
+    // Post-transform cache size the statistics and overdraw clustering simulate, as a FIFO.
+    constexpr unsigned int VertexCacheSize = 16;
+
+    struct VertexCacheStats
+    {
+        size_t triangles;
+        size_t vertices;
+        size_t transformedVertices;
+
+        // average cache miss ratio: vertex shader runs per triangle, 0.5 at best and 3 at worst
+        [[nodiscard]] float getAcmr() const;
+        // average transformed vertex ratio: vertex shader runs per vertex, 1 at best
+        [[nodiscard]] float getAtvr() const;
+
+        VertexCacheStats& operator+=(const VertexCacheStats& other);
+    };
+
+    struct MeshPart
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    struct MeshOptimizationStats
+    {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    VertexCacheStats analyzeVertexCache(std::span<const unsigned int> indices, size_t vertexCount,
+                                        unsigned int cacheSize = VertexCacheSize);
+
+    // Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm).
+    void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+    // Groups cache-optimized triangles into clusters and draws outward-facing clusters first, so fewer fragments
+    // are shaded and then overwritten. A cluster may cost up to threshold times the original ACMR.
+    void optimizeOverdraw(std::vector<unsigned int>& indices, std::span<const Vertex> vertices, float threshold = 1.05f);
+
+    // Stores vertices in the order the indices first use them, dropping unreferenced ones.
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Splits a mesh into parts of at most maxVertices vertices each, keeping the triangle order, so every part can be
+    // drawn with 16-bit indices.
+    std::vector<MeshPart> splitMesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices,
+                                    size_t maxVertices = 65536);
+
+    // Runs all three passes in order.
+    MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+}
+
+#endif // MESH_OPTIMIZER_H
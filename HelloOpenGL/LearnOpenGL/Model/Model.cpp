@@ -1,73 +1,770 @@
 ﻿#include "Model.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <optional>
+#include <unordered_map>
 #include <assimp/Importer.hpp>
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <glad/glad.h>
 #include <glm/gtx/string_cast.hpp>
 
 #include "Material.h"
+#include "MeshCache.h"
+#include "../Graphics/DynamicRingBuffer.h"
+#include "../Graphics/GLStateCache.h"
+#include "../Graphics/TextureRegistry.h"
+#include "../Graphics/UploadScheduler.h"
+#include "../Utilities/Hash.h"
+#include "../Utilities/ThreadPool.h"
 
 namespace LearnOpenGL::Model
 {
+    // Remembers every file Assimp opens besides the model, which the mesh cache has to watch for changes as well.
+    class DependencyRecordingIOSystem : public Assimp::DefaultIOSystem
+    {
+    public:
+        explicit DependencyRecordingIOSystem(std::string modelPath, std::vector<std::string>& dependencies)
+            : _modelPath(std::move(modelPath)), _dependencies(dependencies)
+        {
+        }
+
+        Assimp::IOStream* Open(const char* file, const char* mode) override
+        {
+            Assimp::IOStream* stream = DefaultIOSystem::Open(file, mode);
+
+            if (stream && file != _modelPath && std::ranges::find(_dependencies, file) == _dependencies.end())
+            {
+                _dependencies.emplace_back(file);
+            }
+
+            return stream;
+        }
+
+    private:
+        std::string _modelPath;
+        std::vector<std::string>& _dependencies;
+    };
+
     Model::Model(const std::string& modelPath)
     {
-        loadModel(modelPath);
+        _modelPath = modelPath;
+        _loadStart = std::chrono::steady_clock::now();
+
+        if (!importModel())
+        {
+            _loadStage = ModelLoadStage::Failed;
+            return;
+        }
+
+        _loadStage = ModelLoadStage::UploadingMeshes;
+        continueLoading(std::chrono::steady_clock::time_point::max());
+    }
+
+    Model::Model(AsyncLoad)
+    {
+    }
+
+    Model::~Model()
+    {
+        // the import still writes into this model
+        if (_importTask.valid())
+        {
+            _importTask.wait();
+        }
+
+        std::erase(_asyncLoads, this);
+
+        for (const unsigned int buffer : { _drawTableBuffer, _drawIndexBuffer })
+        {
+            if (buffer != 0)
+            {
+                glDeleteBuffers(1, &buffer);
+            }
+        }
+
+        if (_drawTableTexture != 0)
+        {
+            Graphics::GLStateCache::onTextureDeleted(_drawTableTexture);
+            glDeleteTextures(1, &_drawTableTexture);
+        }
+
+        for (const unsigned int arrayTexture : _textureArrays)
+        {
+            Graphics::GLStateCache::onTextureDeleted(arrayTexture);
+            glDeleteTextures(1, &arrayTexture);
+        }
+    }
+
+    std::unique_ptr<Model> Model::loadAsync(const std::string& modelPath)
+    {
+        std::unique_ptr<Model> model{ new Model(AsyncLoad{}) };
+        model->_modelPath = modelPath;
+        model->_loadStart = std::chrono::steady_clock::now();
+        model->_importTask = Utilities::ThreadPool::getShared().submit([model = model.get()] { return model->importModel(); });
+
+        _asyncLoads.push_back(model.get());
+
+        return model;
+    }
+
+    void Model::updateAsyncLoads(const std::chrono::microseconds budget)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+
+        // earlier loads get the budget first, so models finish one after another instead of all at the end
+        for (size_t i = 0; i < _asyncLoads.size();)
+        {
+            if (_asyncLoads[i]->continueLoading(deadline))
+            {
+                _asyncLoads.erase(_asyncLoads.begin() + static_cast<long long>(i));
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    bool Model::isLoaded() const
+    {
+        return _loadStage == ModelLoadStage::Loaded;
+    }
+
+    ModelLoadProgress Model::getLoadProgress() const
+    {
+        // the counts are only safe to read once the import has handed the model over
+        if (_loadStage == ModelLoadStage::Importing)
+        {
+            return { _loadStage, 0, 0, 0, 0 };
+        }
+
+        return { _loadStage, _meshesUploaded, _meshes.size(), _pendingTexturesUploaded, _pendingTextures.size() };
+    }
+
+    float ModelLoadProgress::getFraction() const
+    {
+        if (stage == ModelLoadStage::Loaded)
+        {
+            return 1.0f;
+        }
+
+        const size_t total = meshCount + textureCount;
+        return total == 0 ? 0.0f : static_cast<float>(meshesUploaded + texturesLoaded) / static_cast<float>(total);
+    }
+
+    const char* ModelLoadProgress::getStageName() const
+    {
+        switch (stage)
+        {
+        case ModelLoadStage::Importing:
+            return "Importing";
+        case ModelLoadStage::UploadingMeshes:
+            return "Uploading meshes";
+        case ModelLoadStage::LoadingTextures:
+            return "Loading textures";
+        case ModelLoadStage::Finalizing:
+            return "Finalizing";
+        case ModelLoadStage::Loaded:
+            return "Loaded";
+        default:
+            return "Failed";
+        }
+    }
+
+    bool Model::continueLoading(const std::chrono::steady_clock::time_point deadline)
+    {
+        const bool blocking = deadline == std::chrono::steady_clock::time_point::max();
+
+        if (_loadStage == ModelLoadStage::Importing)
+        {
+            if (_importTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                return false;
+            }
+
+            if (!_importTask.get())
+            {
+                _loadStage = ModelLoadStage::Failed;
+                return true;
+            }
+
+            _loadStage = ModelLoadStage::UploadingMeshes;
+        }
+
+        if (_loadStage == ModelLoadStage::UploadingMeshes)
+        {
+            while (_meshesUploaded < _meshes.size())
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+
+                _meshes[_meshesUploaded++].upload();
+            }
+
+            startTextureDecodes();
+            _loadStage = ModelLoadStage::LoadingTextures;
+        }
+
+        if (_loadStage == ModelLoadStage::LoadingTextures)
+        {
+            if (!uploadDecodedTextures(deadline, blocking))
+            {
+                return false;
+            }
+
+            _lastUploadTicket = Graphics::UploadScheduler::getShared().getLastTicket();
+            _loadStage = ModelLoadStage::Finalizing;
+        }
+
+        if (_loadStage == ModelLoadStage::Finalizing)
+        {
+            // packing copies the textures on the GPU, so every mesh and texture upload has to have landed first
+            Graphics::UploadScheduler& uploads = Graphics::UploadScheduler::getShared();
+
+            if (!uploads.isComplete(_lastUploadTicket))
+            {
+                if (!blocking)
+                {
+                    return false;
+                }
+
+                uploads.flush();
+            }
+
+            // packing and the draw table are one step each; start them with a fresh budget
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+
+            assignTextureIds();
+            packTextures();
+            setupBounds();
+            setupDrawBatches();
+            logGeometryMemory(_modelPath);
+
+            std::cerr << "Successfully loaded: '" << _modelPath << "' in "
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _loadStart).count() << " ms.\n";
+
+            _loadStage = ModelLoadStage::Loaded;
+        }
+
+        return true;
+    }
+
+    void Model::setupSamplerUnits(const Graphics::Shader& shader)
+    {
+        shader.use();
+        shader.setInt("drawTable", static_cast<int>(DrawTableTextureUnit));
+        shader.setInt("material.diffuseArray", static_cast<int>(Mesh::DiffuseArrayTextureUnit));
+        shader.setInt("material.specularArray", static_cast<int>(Mesh::SpecularArrayTextureUnit));
     }
 
     void Model::draw(const Graphics::Shader& shader) const
     {
+        if (!isLoaded())
+        {
+            return;
+        }
+
         for (const auto& mesh : _meshes)
         {
             mesh.draw(shader);
         }
     }
 
-    void Model::loadModel(const std::string& path)
+    void Model::drawInstanced(const Graphics::Shader& shader, const std::span<const glm::mat4> transforms) const
+    {
+        if (!isLoaded())
+        {
+            return;
+        }
+
+        _instanceData.resize(transforms.size());
+
+        for (size_t i = 0; i < transforms.size(); i++)
+        {
+            _instanceData[i].model = transforms[i];
+            _instanceData[i].normalMatrix = Math::Transform::calculateNormalMatrix(transforms[i]);
+        }
+
+        drawInstanceData(shader);
+    }
+
+    size_t Model::drawInstanced(const Graphics::Shader& shader, const std::span<const glm::mat4> transforms,
+                                const Math::Frustum& frustum) const
+    {
+        if (!isLoaded())
+        {
+            return 0;
+        }
+
+        _instanceData.clear();
+
+        for (const glm::mat4& transform : transforms)
+        {
+            if (!frustum.intersects(_boundingSphere.transformed(transform)) || !frustum.intersects(_bounds.transformed(transform)))
+            {
+                continue;
+            }
+
+            _instanceData.push_back({ transform, Math::Transform::calculateNormalMatrix(transform) });
+        }
+
+        drawInstanceData(shader);
+        return _instanceData.size();
+    }
+
+    MultiDrawStats Model::multiDraw(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix) const
+    {
+        return drawBatches(shader, transform, normalMatrix, nullptr);
+    }
+
+    MultiDrawStats Model::multiDraw(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix,
+                                    const Math::Frustum& frustum) const
+    {
+        return drawBatches(shader, transform, normalMatrix, &frustum);
+    }
+
+    const Math::AABB& Model::getBounds() const
+    {
+        return _bounds;
+    }
+
+    const Math::BoundingSphere& Model::getBoundingSphere() const
+    {
+        return _boundingSphere;
+    }
+
+    void Model::drawInstanceData(const Graphics::Shader& shader) const
+    {
+        if (_instanceData.empty())
+        {
+            return;
+        }
+
+        Graphics::DynamicRingBuffer& ringBuffer = Graphics::DynamicRingBuffer::getShared();
+        const GLintptr instanceOffset = ringBuffer.write(_instanceData);
+
+        if (instanceOffset < 0)
+        {
+            return;
+        }
+
+        shader.use();
+
+        for (const auto& mesh : _meshes)
+        {
+            mesh.bindMaterial(shader);
+            mesh.drawGeometryInstanced(shader, ringBuffer.getId(), static_cast<size_t>(instanceOffset),
+                                       static_cast<int>(_instanceData.size()));
+        }
+    }
+
+    MultiDrawStats Model::drawBatches(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix,
+                                      const Math::Frustum* frustum) const
+    {
+        MultiDrawStats stats{};
+
+        if (!isLoaded() || _drawBatches.empty())
+        {
+            return stats;
+        }
+
+        // commands for every batch go into one buffer, culled meshes are simply never written
+        _drawCommands.clear();
+        _drawCounts.clear();
+        _drawOffsets.clear();
+        _drawBaseVertices.clear();
+
+        std::vector<size_t> batchEnds;
+        batchEnds.reserve(_drawBatches.size());
+
+        for (const DrawBatch& batch : _drawBatches)
+        {
+            for (size_t i = batch.firstMesh; i < batch.firstMesh + batch.meshCount; i++)
+            {
+                const uint32_t meshIndex = _batchedMeshes[i];
+                const Mesh& mesh = _meshes[meshIndex];
+
+                if (frustum && (!frustum->intersects(mesh.getBoundingSphere().transformed(transform))
+                                || !frustum->intersects(mesh.getBounds().transformed(transform))))
+                {
+                    stats.meshesCulled++;
+                    continue;
+                }
+
+                const GeometryAllocation& geometry = mesh.getGeometry();
+
+                if (_useIndirectDraws)
+                {
+                    _drawCommands.push_back({ static_cast<GLuint>(geometry.getIndexCount()), 1, geometry.getFirstIndex(),
+                                              geometry.getBaseVertex(), meshIndex });
+                }
+                else
+                {
+                    _drawCounts.push_back(geometry.getIndexCount());
+                    _drawOffsets.push_back(geometry.getIndexOffset());
+                    _drawBaseVertices.push_back(geometry.getBaseVertex());
+                }
+            }
+
+            batchEnds.push_back(_useIndirectDraws ? _drawCommands.size() : _drawCounts.size());
+        }
+
+        shader.use();
+        shader.setMat4("model", transform);
+        shader.setMat3("normalMatrix", normalMatrix);
+        shader.setBool("useDrawTable", true);
+        Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + DrawTableTextureUnit, GL_TEXTURE_BUFFER, _drawTableTexture);
+
+        GLintptr commandsOffset = 0;
+
+        if (_useIndirectDraws && !_drawCommands.empty())
+        {
+            Graphics::DynamicRingBuffer& ringBuffer = Graphics::DynamicRingBuffer::getShared();
+            commandsOffset = ringBuffer.write(_drawCommands);
+
+            if (commandsOffset < 0)
+            {
+                return stats;
+            }
+
+            glBindBuffer(Graphics::DrawIndirectBufferTarget, ringBuffer.getId());
+        }
+
+        size_t batchStart = 0;
+
+        for (size_t b = 0; b < _drawBatches.size(); b++)
+        {
+            const DrawBatch& batch = _drawBatches[b];
+            const size_t drawCount = batchEnds[b] - batchStart;
+
+            if (drawCount == 0)
+            {
+                continue;
+            }
+
+            // every mesh in the batch binds the same textures
+            _meshes[_batchedMeshes[batch.firstMesh]].bindMaterial(shader);
+
+            if (_useIndirectDraws)
+            {
+                GeometryArena::getShared().bindDrawIndices(batch.vertexFormat, _drawIndexBuffer);
+                Graphics::GLExtensions::multiDrawElementsIndirect(
+                    GL_TRIANGLES, batch.indexType,
+                    reinterpret_cast<const void*>(commandsOffset + sizeof(Graphics::DrawElementsIndirectCommand) * batchStart),
+                    static_cast<GLsizei>(drawCount), 0);
+            }
+            else
+            {
+                // without baseInstance there is one draw index per call, so these batches only hold meshes with equal records
+                GeometryArena::getShared().bindDrawIndices(batch.vertexFormat, 0);
+                glVertexAttribI1i(DrawIndexLocation, static_cast<GLint>(_batchedMeshes[batch.firstMesh]));
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, &_drawCounts[batchStart], batch.indexType, &_drawOffsets[batchStart],
+                                              static_cast<GLsizei>(drawCount), &_drawBaseVertices[batchStart]);
+            }
+
+            stats.drawCalls++;
+            stats.meshesDrawn += drawCount;
+            batchStart = batchEnds[b];
+        }
+
+        shader.setBool("useDrawTable", false);
+
+        return stats;
+    }
+
+    void Model::setupDrawBatches()
+    {
+        if (_meshes.empty())
+        {
+            return;
+        }
+
+        _useIndirectDraws = Graphics::GLExtensions::supportsMultiDrawIndirect();
+
+        std::vector<DrawRecord> records;
+        records.reserve(_meshes.size());
+
+        for (const Mesh& mesh : _meshes)
+        {
+            const bool compact = mesh.getVertexFormat() == VertexFormat::Compact;
+            const VertexQuantization& quantization = mesh.getQuantization();
+
+            // textured meshes take their colors from the textures, as Mesh::bindMaterial does
+            const Material material = mesh.textures.empty() ? mesh.material : Material{};
+            const float shininess = mesh.textures.empty() ? mesh.material.shininess : -1.0f;
+
+            records.push_back({
+                glm::vec4(quantization.offset, compact ? 1.0f : 0.0f), glm::vec4(quantization.scale * 65535.0f, 0.0f),
+                glm::vec4(material.diffuseColor, shininess), glm::vec4(material.specularColor, 0.0f),
+                glm::vec4(material.emissionColor, 0.0f),
+                glm::vec4(static_cast<float>(mesh.diffuseLayer.layer), static_cast<float>(mesh.specularLayer.layer),
+                          mesh.usesTextureArrays() ? 1.0f : 0.0f, 0.0f),
+                mesh.diffuseLayer.rectangle, mesh.specularLayer.rectangle
+            });
+        }
+
+        // group meshes that can share a call, keeping the order they were first seen in
+        std::unordered_map<uint64_t, size_t> batchIndices;
+        std::vector<std::vector<uint32_t>> batchMeshes;
+
+        for (uint32_t i = 0; i < _meshes.size(); i++)
+        {
+            const Mesh& mesh = _meshes[i];
+            const VertexFormat vertexFormat = mesh.getVertexFormat();
+            const GLenum indexType = mesh.getGeometry().getIndexType();
+            const uint64_t textureKey = mesh.getTextureKey();
+
+            uint64_t key = Utilities::hashBytes(&vertexFormat, sizeof(vertexFormat));
+            key = Utilities::hashBytes(&indexType, sizeof(indexType), key);
+            key = Utilities::hashBytes(&textureKey, sizeof(textureKey), key);
+
+            if (!_useIndirectDraws)
+            {
+                key = Utilities::hashBytes(&records[i], sizeof(DrawRecord), key);
+            }
+
+            const auto [batch, inserted] = batchIndices.try_emplace(key, batchMeshes.size());
+
+            if (inserted)
+            {
+                batchMeshes.emplace_back();
+                _drawBatches.push_back({ vertexFormat, indexType, 0, 0 });
+            }
+
+            batchMeshes[batch->second].push_back(i);
+        }
+
+        _batchedMeshes.reserve(_meshes.size());
+
+        for (size_t b = 0; b < _drawBatches.size(); b++)
+        {
+            _drawBatches[b].firstMesh = _batchedMeshes.size();
+            _drawBatches[b].meshCount = batchMeshes[b].size();
+            _batchedMeshes.insert(_batchedMeshes.end(), batchMeshes[b].begin(), batchMeshes[b].end());
+        }
+
+        glGenBuffers(1, &_drawTableBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, _drawTableBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<long long>(sizeof(DrawRecord) * records.size()), records.data(), GL_STATIC_DRAW);
+
+        glGenTextures(1, &_drawTableTexture);
+        Graphics::GLStateCache::bindTexture(GL_TEXTURE0 + DrawTableTextureUnit, GL_TEXTURE_BUFFER, _drawTableTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _drawTableBuffer);
+
+        if (_useIndirectDraws)
+        {
+            std::vector<int> drawIndices(_meshes.size());
+
+            for (size_t i = 0; i < drawIndices.size(); i++)
+            {
+                drawIndices[i] = static_cast<int>(i);
+            }
+
+            glGenBuffers(1, &_drawIndexBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _drawIndexBuffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<long long>(sizeof(int) * drawIndices.size()), drawIndices.data(),
+                         GL_STATIC_DRAW);
+        }
+
+        if (debugLogging)
+        {
+            std::cerr << "Grouped " << _meshes.size() << " meshes into " << _drawBatches.size() << " multi-draw batches ("
+                << (_useIndirectDraws ? "indirect" : "base vertex fallback") << ").\n";
+        }
+    }
+
+    void Model::submit(Graphics::RenderQueue& queue, const Graphics::Shader& shader, const glm::mat4& transform,
+                       const glm::mat3& normalMatrix) const
+    {
+        if (!isLoaded())
+        {
+            return;
+        }
+
+        for (const auto& mesh : _meshes)
+        {
+            queue.submit(shader, mesh, transform, normalMatrix);
+        }
+    }
+
+    void Model::submit(Graphics::RenderQueue& queue, const Graphics::Shader& shader, Math::Transform& transform) const
     {
+        submit(queue, shader, transform.get(), transform.getNormalMatrix());
+    }
+
+    void Model::submit(Graphics::RenderQueue& queue, Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                       const glm::mat4& transform, const glm::mat3& normalMatrix) const
+    {
+        if (!isLoaded())
+        {
+            return;
+        }
+
+        for (const auto& mesh : _meshes)
+        {
+            queue.submit(variants.get({ scene.features | mesh.getShaderFeatures(), scene.pointLights }), mesh, transform, normalMatrix);
+        }
+    }
+
+    void Model::submit(Graphics::RenderQueue& queue, Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                       Math::Transform& transform) const
+    {
+        submit(queue, variants, scene, transform.get(), transform.getNormalMatrix());
+    }
+
+    bool Model::importModel()
+    {
+        const auto importStart = std::chrono::steady_clock::now();
+        const auto elapsedMilliseconds = [&importStart]
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - importStart).count();
+        };
+
+        const std::string& path = _modelPath;
+        _modelDirectory = path.substr(0, path.find_last_of('/'));
+
+        const std::string cachePath = MeshCache::getCachePath(path);
+        const std::optional<uint64_t> sourceHash = useMeshCache ? Utilities::hashFile(path) : std::nullopt;
+
+        const MeshCacheKey cacheKey{ sourceHash.value_or(0), ImportFlags, optimizeMeshes ? MeshProcessingOptimized : 0 };
+
+        if (sourceHash && loadFromMeshCache(cachePath, cacheKey))
+        {
+            std::cerr << "Read '" << path << "' from mesh cache in " << elapsedMilliseconds() << " ms.\n";
+            return true;
+        }
+
+        std::unique_lock<std::mutex> loggerLock{ _importLoggerMutex, std::defer_lock };
+
         if (debugLogging)
         {
+            loggerLock.lock();
             Assimp::DefaultLogger::create(std::string("load logger for ").append(path).c_str(), Assimp::Logger::VERBOSE);
             Assimp::LogStream* stderrStream = Assimp::LogStream::createDefaultStream(aiDefaultLogStream_STDERR);
             Assimp::DefaultLogger::get()->attachStream(
                 stderrStream, Assimp::Logger::NORMAL | Assimp::Logger::DEBUGGING | Assimp::Logger::VERBOSE);
         }
 
+        std::vector<std::string> dependencyPaths;
+
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(
-            path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+        // the importer owns and deletes its IO handler
+        importer.SetIOHandler(new DependencyRecordingIOSystem(path, dependencyPaths));
+        const aiScene* scene = importer.ReadFile(path, ImportFlags);
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
             std::cerr << "Assimp Error: " << importer.GetErrorString() << '\n';
             Assimp::DefaultLogger::kill();
-            return;
+            return false;
         }
 
-        _modelDirectory = path.substr(0, path.find_last_of('/'));
-        processNode(scene->mRootNode, scene);
+        processNode(scene->mRootNode, scene, -1);
+
+        if (optimizeMeshes && debugLogging)
+        {
+            // simulated with a FIFO of VertexCacheSize entries
+            std::cerr << "Optimized " << _meshes.size() << " meshes in " << _optimizationMilliseconds << " ms: ACMR "
+                << _optimizationStats.before.getAcmr() << " -> " << _optimizationStats.after.getAcmr() << ", ATVR "
+                << _optimizationStats.before.getAtvr() << " -> " << _optimizationStats.after.getAtvr() << ", "
+                << _optimizationStats.before.transformedVertices << " -> " << _optimizationStats.after.transformedVertices
+                << " vertex shader runs.\n";
+        }
 
-        std::cerr << "Successfully imported: '" << path << "'.\n";
+        std::cerr << "Successfully imported: '" << path << "' in " << elapsedMilliseconds() << " ms.\n";
         Assimp::DefaultLogger::kill();
+
+        if (sourceHash && MeshCache::write(cachePath, cacheKey, _meshes, _nodes, dependencyPaths) && debugLogging)
+        {
+            std::cerr << "Wrote mesh cache for '" << path << "' to '" << cachePath << "'.\n";
+        }
+
+        return true;
     }
 
-    void Model::processNode(const aiNode* node, const aiScene* scene)
+    bool Model::loadFromMeshCache(const std::string& cachePath, const MeshCacheKey& key)
     {
+        const MeshCache cache{ cachePath, key };
+
+        if (!cache.isValid())
+        {
+            if (debugLogging)
+            {
+                std::cerr << "No valid mesh cache at '" << cachePath << "', importing with Assimp.\n";
+            }
+
+            return false;
+        }
+
+        const std::span<const Vertex> vertices = cache.getVertices();
+        const std::span<const unsigned int> indices = cache.getIndices();
+        const std::span<const MeshCacheMaterial> materials = cache.getMaterials();
+        const std::span<const MeshCacheTexture> textures = cache.getTextures();
+
+        _meshes.reserve(cache.getMeshes().size());
+
+        for (const MeshCacheMesh& cachedMesh : cache.getMeshes())
+        {
+            const MeshCacheMaterial& cachedMaterial = materials[cachedMesh.materialIndex];
+
+            std::vector<Texture> meshTextures;
+            for (const MeshCacheTexture& texture : textures.subspan(cachedMaterial.firstTexture, cachedMaterial.textureCount))
+            {
+                meshTextures.push_back(loadTexture(std::string(cache.getString(texture.pathOffset, texture.pathLength)),
+                                                   std::string(cache.getString(texture.typeOffset, texture.typeLength))));
+            }
+
+            const auto meshVertices = vertices.subspan(cachedMesh.firstVertex, cachedMesh.vertexCount);
+            const auto meshIndices = indices.subspan(cachedMesh.firstIndex, cachedMesh.indexCount);
+
+            Mesh mesh{
+                { meshVertices.begin(), meshVertices.end() }, { meshIndices.begin(), meshIndices.end() }, meshTextures,
+                cachedMaterial.material, selectMeshVertexFormat(meshVertices)
+            };
+            mesh.materialIndex = cachedMesh.materialIndex;
+
+            _meshes.push_back(std::move(mesh));
+        }
+
+        const std::span<const MeshCacheNode> nodes = cache.getNodes();
+        _nodes.assign(nodes.begin(), nodes.end());
+
+        return true;
+    }
+
+    void Model::processNode(const aiNode* node, const aiScene* scene, const int parentNode)
+    {
+        const auto nodeIndex = static_cast<int>(_nodes.size());
+        const auto firstMesh = static_cast<uint32_t>(_meshes.size());
+        _nodes.push_back({ parentNode, firstMesh, 0 });
+
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            _meshes.push_back(processMesh(mesh, scene));
+            processMesh(mesh, scene);
         }
 
+        _nodes[nodeIndex].meshCount = static_cast<uint32_t>(_meshes.size()) - firstMesh;
+
         // then do the same for each of its children
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, nodeIndex);
         }
     }
 
-    Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+    void Model::processMesh(aiMesh* mesh, const aiScene* scene)
     {
         if (debugLogging)
         {
@@ -100,6 +797,16 @@ namespace LearnOpenGL::Model
                 vertex.normal = v3;
             }
 
+            if (mesh->HasTangentsAndBitangents())
+            {
+                const glm::vec3 tangent{ mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
+                const glm::vec3 bitangent{ mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
+
+                // only the bitangent's direction is kept; shaders rebuild it from the normal and tangent
+                const float handedness = glm::dot(glm::cross(vertex.normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+                vertex.tangent = glm::vec4(tangent, handedness);
+            }
+
             if (mesh->mTextureCoords[0])
             {
                 glm::vec2 v2;
@@ -126,6 +833,23 @@ namespace LearnOpenGL::Model
             }
         }
 
+        if (optimizeMeshes)
+        {
+            const auto optimizeStart = std::chrono::steady_clock::now();
+            const MeshOptimizationStats stats = optimizeMesh(vertices, indices);
+            _optimizationMilliseconds +=
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - optimizeStart).count();
+
+            _optimizationStats.before += stats.before;
+            _optimizationStats.after += stats.after;
+
+            if (debugLogging)
+            {
+                std::cerr << "Optimized " << mesh->mName.C_Str() << ": ACMR " << stats.before.getAcmr() << " -> "
+                    << stats.after.getAcmr() << ", ATVR " << stats.before.getAtvr() << " -> " << stats.after.getAtvr() << '\n';
+            }
+        }
+
         aiMaterial* aiMaterial = scene->mMaterials[mesh->mMaterialIndex];
 
         std::vector<Texture> diffuseMaps = loadMaterialTextures(aiMaterial, aiTextureType_DIFFUSE, "diffuse");
@@ -148,7 +872,33 @@ namespace LearnOpenGL::Model
 
         Material colorMaterial = loadMaterial(aiMaterial);
 
-        return Mesh{ vertices, indices, textures, colorMaterial };
+        if (vertices.size() <= Mesh::MaxShortIndexVertices)
+        {
+            Mesh result{ vertices, indices, textures, colorMaterial, selectMeshVertexFormat(vertices) };
+            result.materialIndex = mesh->mMaterialIndex;
+
+            _meshes.push_back(std::move(result));
+            return;
+        }
+
+        // a few more draws cost less than fetching twice the index data for every one of them
+        std::vector<MeshPart> parts = splitMesh(vertices, indices, Mesh::MaxShortIndexVertices);
+
+        if (debugLogging)
+        {
+            std::cerr << "Split " << mesh->mName.C_Str() << " (" << vertices.size() << " vertices) into " << parts.size()
+                << " meshes for 16-bit indices.\n";
+        }
+
+        for (MeshPart& part : parts)
+        {
+            const VertexFormat vertexFormat = selectMeshVertexFormat(part.vertices);
+
+            Mesh result{ std::move(part.vertices), std::move(part.indices), textures, colorMaterial, vertexFormat };
+            result.materialIndex = mesh->mMaterialIndex;
+
+            _meshes.push_back(std::move(result));
+        }
     }
 
     Material Model::loadMaterial(const aiMaterial* aiMaterial)
@@ -186,31 +936,288 @@ namespace LearnOpenGL::Model
             mat->GetTexture(type, i, &str);
             std::cerr << str.C_Str() << '\n';
 
-            bool textureAlreadyLoaded = false;
+            textures.push_back(loadTexture(str.C_Str(), typeName));
+        }
+
+        return textures;
+    }
 
-            for (auto& texture : _texturesLoaded)
+    Texture Model::loadTexture(const std::string& texturePath, const std::string& typeName)
+    {
+        if (const auto texture = _texturesLoaded.find(texturePath); texture != _texturesLoaded.end())
+        {
+            return texture->second;
+        }
+
+        // only recorded here; startTextureDecodes decodes the image on a worker and uploadDecodedTextures uploads it
+        Texture texture;
+
+        texture.id = 0;
+        texture.type = typeName;
+        texture.path = texturePath;
+
+        _texturesLoaded.insert({ texturePath, texture });
+
+        return texture;
+    }
+
+    void Model::startTextureDecodes()
+    {
+        std::unordered_map<std::string, size_t> pendingByPath;
+
+        for (auto& [path, texture] : _texturesLoaded)
+        {
+            if (texture.id != 0)
+            {
+                continue;
+            }
+
+            std::string canonicalPath = Graphics::TextureRegistry::canonicalizePath(_modelDirectory + '/' + path);
+
+            // another model (or this one, through a different relative path) already uploaded it
+            if (std::optional<Graphics::Texture2D> registered = Graphics::TextureRegistry::findByPath(canonicalPath))
+            {
+                texture.id = registered->getId();
+                _textureReferences.push_back(std::move(*registered));
+                continue;
+            }
+
+            if (const auto pending = pendingByPath.find(canonicalPath); pending != pendingByPath.end())
+            {
+                _pendingTextures[pending->second].textures.push_back(&texture);
+                continue;
+            }
+
+            // decode every missing image concurrently, since stbi_load does not touch any GL state
+            pendingByPath.insert({ canonicalPath, _pendingTextures.size() });
+            std::future<Graphics::Image> decode = Utilities::ThreadPool::getShared().submit(
+                [canonicalPath] { return Graphics::Image::loadFromFile(canonicalPath); });
+
+            _pendingTextures.push_back({ std::move(canonicalPath), { &texture }, std::move(decode) });
+        }
+    }
+
+    bool Model::uploadDecodedTextures(const std::chrono::steady_clock::time_point deadline, const bool blocking)
+    {
+        // uploads have to stay on the context thread; they run as decodes finish, so later images keep decoding meanwhile
+        while (_pendingTexturesUploaded < _pendingTextures.size())
+        {
+            PendingTexture& pending = _pendingTextures[_pendingTexturesUploaded];
+
+            if (std::chrono::steady_clock::now() >= deadline
+                || (!blocking && pending.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+            {
+                return false;
+            }
+
+            Graphics::Image image = pending.decode.get();
+            const uint64_t contentHash = image.getContentHash();
+            std::optional<Graphics::Texture2D> registered = Graphics::TextureRegistry::findByContent(pending.canonicalPath, contentHash);
+
+            if (!registered && image.isValid())
+            {
+                // the mip chain adds about a third on top of the base level
+                const size_t residentBytes = image.getByteSize() + image.getByteSize() / 3;
+                const unsigned int textureId = Texture::upload(std::move(image), pending.canonicalPath);
+
+                registered = Graphics::TextureRegistry::add(pending.canonicalPath, contentHash, textureId, residentBytes);
+            }
+
+            const unsigned int textureId = registered ? registered->getId() : 0;
+            for (Texture* texture : pending.textures)
+            {
+                texture->id = textureId;
+            }
+
+            if (registered)
+            {
+                _textureReferences.push_back(std::move(*registered));
+            }
+            else
+            {
+                std::cerr << "Failed to load texture at " << pending.canonicalPath << "\n";
+            }
+
+            _pendingTexturesUploaded++;
+        }
+
+        return true;
+    }
+
+    void Model::assignTextureIds()
+    {
+        for (auto& mesh : _meshes)
+        {
+            for (auto& texture : mesh.textures)
+            {
+                texture.id = _texturesLoaded[texture.path].id;
+            }
+        }
+
+        if (debugLogging)
+        {
+            const Graphics::TextureRegistryStats stats = Graphics::TextureRegistry::getStats();
+            std::cerr << "Decoded " << _pendingTextures.size() << " textures on " << Utilities::ThreadPool::getShared().getThreadCount()
+                << " worker threads. Texture registry: " << stats.hits << " hits, " << stats.contentHits << " content hits, "
+                << stats.misses << " misses, " << stats.bytesResident / (1024 * 1024) << " MiB resident.\n";
+        }
+    }
+
+    void Model::packTextures()
+    {
+        if (!packTextureArrays)
+        {
+            return;
+        }
+
+        // the shaders only sample each mesh's first diffuse and specular texture
+        const auto findTexture = [](const Mesh& mesh, const std::string& type) -> unsigned int
+        {
+            const auto texture = std::ranges::find(mesh.textures, type, &Texture::type);
+            return texture != mesh.textures.end() ? texture->id : 0;
+        };
+
+        // atlas entries cannot repeat, so textures only go into an atlas when every mesh using them stays within [0, 1]
+        std::vector<unsigned int> textureIds;
+        std::unordered_map<unsigned int, bool> fitsAtlas;
+
+        for (const Mesh& mesh : _meshes)
+        {
+            const bool unitTextureCoordinates = std::ranges::all_of(mesh.vertices, [](const Vertex& vertex)
             {
-                if (std::strcmp(texture.path.data(), str.C_Str()) == 0)
+                return glm::all(glm::greaterThanEqual(vertex.textureCoordinates, glm::vec2(0.0f)))
+                    && glm::all(glm::lessThanEqual(vertex.textureCoordinates, glm::vec2(1.0f)));
+            });
+
+            for (const unsigned int textureId : { findTexture(mesh, "diffuse"), findTexture(mesh, "specular") })
+            {
+                if (textureId == 0)
+                {
+                    continue;
+                }
+
+                if (const auto [entry, inserted] = fitsAtlas.try_emplace(textureId, unitTextureCoordinates); inserted)
+                {
+                    textureIds.push_back(textureId);
+                }
+                else
                 {
-                    textures.push_back(texture);
-                    textureAlreadyLoaded = true;
-                    break;
+                    entry->second = entry->second && unitTextureCoordinates;
                 }
             }
+        }
 
-            if (!textureAlreadyLoaded)
-            {
-                Texture texture;
+        if (textureIds.empty())
+        {
+            return;
+        }
+
+        TextureArrayPacker packer;
+        std::unordered_map<unsigned int, size_t> packedIndices;
+
+        for (const unsigned int textureId : textureIds)
+        {
+            packedIndices.insert({ textureId, packer.add(textureId, fitsAtlas[textureId]) });
+        }
 
-                texture.id = Texture::loadFromFile(str.C_Str(), _modelDirectory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
+        const std::vector<TextureArrayLocation> locations = packer.pack(_textureArrays);
 
-                _texturesLoaded.push_back(texture);
+        // a mesh only switches over once everything it samples made it into an array
+        std::unordered_map<unsigned int, bool> stillBound;
+
+        for (Mesh& mesh : _meshes)
+        {
+            const unsigned int diffuseId = findTexture(mesh, "diffuse");
+            const unsigned int specularId = findTexture(mesh, "specular");
+            const TextureArrayLocation diffuse = diffuseId != 0 ? locations[packedIndices[diffuseId]] : TextureArrayLocation{};
+            const TextureArrayLocation specular = specularId != 0 ? locations[packedIndices[specularId]] : TextureArrayLocation{};
+
+            const bool packed = (diffuseId == 0 || diffuse.arrayTexture != 0) && (specularId == 0 || specular.arrayTexture != 0);
+
+            if (packed && (diffuseId != 0 || specularId != 0))
+            {
+                mesh.diffuseLayer = diffuse;
+                mesh.specularLayer = specular;
+            }
+
+            for (const auto& texture : mesh.textures)
+            {
+                stillBound[texture.id] = stillBound[texture.id] || !mesh.usesTextureArrays();
             }
         }
 
-        return textures;
+        // drop the originals nothing binds anymore; the texture registry deletes them unless another model holds them too
+        const size_t referenceCount = _textureReferences.size();
+        std::erase_if(_textureReferences, [&stillBound](const Graphics::Texture2D& texture) { return !stillBound[texture.getId()]; });
+
+        if (debugLogging)
+        {
+            const TextureArrayPackerStats& stats = packer.getStats();
+            std::cerr << "Packed " << stats.textures << " textures into " << stats.arrays << " texture arrays (" << stats.layers
+                << " layers, " << stats.atlasTextures << " in atlases, " << static_cast<double>(stats.bytes) / (1024.0 * 1024.0)
+                << " MiB), released " << referenceCount - _textureReferences.size() << " textures.\n";
+        }
+    }
+
+    void Model::setupBounds()
+    {
+        if (_meshes.empty())
+        {
+            return;
+        }
+
+        _bounds = _meshes.front().getBounds();
+
+        for (const auto& mesh : _meshes)
+        {
+            _bounds = _bounds.merged(mesh.getBounds());
+        }
+
+        const glm::vec3 center = _bounds.getCenter();
+        float radius = 0.0f;
+
+        for (const auto& mesh : _meshes)
+        {
+            const Math::BoundingSphere& sphere = mesh.getBoundingSphere();
+            radius = std::max(radius, glm::distance(center, sphere.center) + sphere.radius);
+        }
+
+        _boundingSphere = { center, radius };
+    }
+
+    void Model::logGeometryMemory(const std::string& path) const
+    {
+        if (!debugLogging)
+        {
+            return;
+        }
+
+        size_t compactMeshes = 0;
+        size_t shortIndexMeshes = 0;
+        size_t uploadedBytes = 0;
+        size_t fullBytes = 0;
+        size_t indexBytes = 0;
+        size_t fullIndexBytes = 0;
+
+        for (const auto& mesh : _meshes)
+        {
+            compactMeshes += mesh.getVertexFormat() == VertexFormat::Compact;
+            uploadedBytes += mesh.getVertexBufferSize();
+            fullBytes += sizeof(Vertex) * mesh.vertices.size();
+
+            shortIndexMeshes += mesh.vertices.size() <= Mesh::MaxShortIndexVertices;
+            indexBytes += mesh.getIndexBufferSize();
+            fullIndexBytes += sizeof(unsigned int) * mesh.indices.size();
+        }
+
+        std::cerr << "'" << path << "': " << compactMeshes << '/' << _meshes.size() << " meshes use compact vertices, "
+            << uploadedBytes / 1024 << " KiB of vertex data uploaded (" << fullBytes / 1024 << " KiB uncompressed).\n";
+        std::cerr << "'" << path << "': " << shortIndexMeshes << '/' << _meshes.size() << " meshes use 16-bit indices, "
+            << indexBytes / 1024 << " KiB of index data uploaded (" << fullIndexBytes / 1024 << " KiB as 32-bit).\n";
+    }
+
+    VertexFormat Model::selectMeshVertexFormat(const std::span<const Vertex> vertices)
+    {
+        return useCompactVertices ? selectVertexFormat(vertices) : VertexFormat::Full;
     }
 }
@@ -3,33 +3,250 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include "InstanceData.h"
 #include "Material.h"
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "../Graphics/GLExtensions.h"
+#include "../Graphics/RenderQueue.h"
 #include "../Graphics/Shader.h"
+#include "../Graphics/ShaderVariants.h"
+#include "../Graphics/Texture2D.h"
+#include "../Graphics/UploadScheduler.h"
+#include "../Math/Bounds.h"
+#include "../Math/Frustum.h"
+#include "../Math/Transform.h"
 
 namespace LearnOpenGL::Model
 {
+    struct MultiDrawStats
+    {
+        size_t drawCalls;
+        size_t meshesDrawn;
+        // skipped for lying outside the frustum
+        size_t meshesCulled;
+    };
+
+    enum class ModelLoadStage
+    {
+        Importing,
+        UploadingMeshes,
+        LoadingTextures,
+        Finalizing,
+        Loaded,
+        Failed
+    };
+
+    struct ModelLoadProgress
+    {
+        ModelLoadStage stage;
+        size_t meshesUploaded;
+        size_t meshCount;
+        size_t texturesLoaded;
+        size_t textureCount;
+
+        // share of the uploads done, counting meshes and textures alike; 0 while importing
+        [[nodiscard]] float getFraction() const;
+        [[nodiscard]] const char* getStageName() const;
+    };
+
     class Model
     {
     public:
+        // Loads the whole model before returning.
         explicit Model(const std::string& modelPath);
+        Model(const Model&) = delete;
+        Model& operator=(const Model&) = delete;
+        ~Model();
+
+        // Imports the model on a worker thread and returns at once. The model draws nothing until updateAsyncLoads
+        // has finished uploading it on the context thread.
+        static std::unique_ptr<Model> loadAsync(const std::string& modelPath);
+        // Continues every asynchronous load, spending at most budget on GL uploads between them. Call once per frame
+        // on the context thread.
+        static void updateAsyncLoads(std::chrono::microseconds budget);
+
+        [[nodiscard]] bool isLoaded() const;
+        [[nodiscard]] ModelLoadProgress getLoadProgress() const;
+
         void draw(const Graphics::Shader& shader) const;
+        // Draws the model once per transform in a single instanced call per mesh. Expects a shader built on
+        // vertex_instanced.glsl, which reads the model and normal matrices as vertex attributes.
+        void drawInstanced(const Graphics::Shader& shader, std::span<const glm::mat4> transforms) const;
+        // Same, but skips instances whose bounds fall outside the frustum. Returns the number of instances drawn.
+        size_t drawInstanced(const Graphics::Shader& shader, std::span<const glm::mat4> transforms,
+                             const Math::Frustum& frustum) const;
+        // Queues every mesh instead of drawing it, leaving the draw order to the render queue.
+        void submit(Graphics::RenderQueue& queue, const Graphics::Shader& shader, const glm::mat4& transform,
+                    const glm::mat3& normalMatrix) const;
+        void submit(Graphics::RenderQueue& queue, const Graphics::Shader& shader, Math::Transform& transform) const;
+        // Same, queuing each mesh with the cheapest variant for its material on top of the scene's features.
+        void submit(Graphics::RenderQueue& queue, Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                    const glm::mat4& transform, const glm::mat3& normalMatrix) const;
+        void submit(Graphics::RenderQueue& queue, Graphics::ShaderVariants& variants, const Graphics::ShaderPermutation& scene,
+                    Math::Transform& transform) const;
+
+        // Draws every mesh with one multi-draw call per batch of meshes sharing a vertex format, index type and textures.
+        // Each draw reads its material colors and vertex quantization from the model's draw table, so culling a mesh
+        // only drops its command. Expects shaders that read the draw table (vertex.glsl, phong.frag).
+        MultiDrawStats multiDraw(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix) const;
+        MultiDrawStats multiDraw(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix,
+                                 const Math::Frustum& frustum) const;
+
+        // texture unit multiDraw binds the draw table to
+        static constexpr unsigned int DrawTableTextureUnit = 15;
+        // Points the draw table and texture array samplers at their units. Needed once per shader before its first draw,
+        // since samplers of different types must never share a unit, even while unused.
+        static void setupSamplerUnits(const Graphics::Shader& shader);
         inline static bool debugLogging = false;
 
+        // Imported meshes are written to "<model path>.meshcache" and loaded from there on later runs,
+        // as long as the model file and import flags have not changed. Disable to always import through Assimp.
+        inline static bool useMeshCache = true;
+
+        // Reorders each imported mesh for the vertex cache, overdraw and vertex fetch (see MeshOptimizer.h).
+        inline static bool optimizeMeshes = true;
+
+        // Uploads meshes as CompactVertex wherever that loses no visible precision (see VertexFormat.h).
+        inline static bool useCompactVertices = true;
+
+        // Copies the diffuse and specular textures into texture arrays after loading (see TextureArrayPacker.h),
+        // so meshes with different textures can share one binding and one multi-draw.
+        inline static bool packTextureArrays = true;
+
+        // model-space bounds around every mesh
+        [[nodiscard]] const Math::AABB& getBounds() const;
+        [[nodiscard]] const Math::BoundingSphere& getBoundingSphere() const;
+
     private:
+        struct AsyncLoad
+        {
+        };
+
+        // decoded on the thread pool, uploaded on the context thread
+        struct PendingTexture
+        {
+            std::string canonicalPath;
+            std::vector<Texture*> textures;
+            std::future<Graphics::Image> decode;
+        };
+
+        static constexpr unsigned int ImportFlags =
+            aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+
+        // models still being uploaded by updateAsyncLoads
+        inline static std::vector<Model*> _asyncLoads;
+        // Assimp's logger is global, so imports with debug logging take turns
+        inline static std::mutex _importLoggerMutex;
+
+        std::string _modelPath;
+        std::chrono::steady_clock::time_point _loadStart;
+        ModelLoadStage _loadStage = ModelLoadStage::Importing;
+        // everything importModel fills in belongs to the worker thread until this is ready
+        std::future<bool> _importTask;
+        size_t _meshesUploaded = 0;
+        std::vector<PendingTexture> _pendingTextures;
+        size_t _pendingTexturesUploaded = 0;
+        // covers the model's geometry and texture uploads in the UploadScheduler
+        Graphics::UploadTicket _lastUploadTicket = 0;
+
         std::vector<Mesh> _meshes;
-        std::vector<Texture> _texturesLoaded;
+        std::vector<MeshCacheNode> _nodes;
+        MeshOptimizationStats _optimizationStats{};
+        double _optimizationMilliseconds = 0.0;
+        Math::AABB _bounds;
+        Math::BoundingSphere _boundingSphere;
+        // per-instance matrices, rebuilt and written to the DynamicRingBuffer on every instanced draw
+        mutable std::vector<InstanceData> _instanceData;
+        std::unordered_map<std::string, Texture> _texturesLoaded;
+        // keeps the model's textures alive in the shared TextureRegistry
+        std::vector<Graphics::Texture2D> _textureReferences;
+        // the model's own texture arrays, when its textures were packed
+        std::vector<unsigned int> _textureArrays;
         std::string _modelDirectory;
 
-        void loadModel(const std::string& path);
-        void processNode(const aiNode* node, const aiScene* scene);
-        Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+        // one draw table entry per mesh, DrawRecordTexels RGBA32F texels
+        struct DrawRecord
+        {
+            // w is 1 for compact vertices
+            glm::vec4 positionOffset;
+            glm::vec4 positionScale;
+            // w is the shininess, negative for textured meshes
+            glm::vec4 diffuseColor;
+            glm::vec4 specularColor;
+            glm::vec4 emissionColor;
+            // x, y: diffuse and specular layers, -1 without one; z is 1 when the mesh samples texture arrays
+            glm::vec4 textureLayers;
+            // layer rectangles, scale in xy and offset in zw
+            glm::vec4 diffuseRectangle;
+            glm::vec4 specularRectangle;
+        };
+
+        static constexpr size_t DrawRecordTexels = sizeof(DrawRecord) / sizeof(glm::vec4);
+
+        // meshes drawn by one multi-draw call, as a range of _batchedMeshes
+        struct DrawBatch
+        {
+            VertexFormat vertexFormat;
+            GLenum indexType;
+            size_t firstMesh;
+            size_t meshCount;
+        };
+
+        std::vector<DrawBatch> _drawBatches;
+        std::vector<uint32_t> _batchedMeshes;
+        // draw records as a texture buffer, and 0..n-1 as a per-instance attribute so baseInstance selects each draw's record
+        unsigned int _drawTableBuffer{};
+        unsigned int _drawTableTexture{};
+        unsigned int _drawIndexBuffer{};
+        bool _useIndirectDraws = false;
+        // rebuilt on every multi-draw; the counts, offsets and base vertices feed glMultiDrawElementsBaseVertex
+        // when multi-draw indirect is unavailable
+        mutable std::vector<Graphics::DrawElementsIndirectCommand> _drawCommands;
+        mutable std::vector<GLsizei> _drawCounts;
+        mutable std::vector<const void*> _drawOffsets;
+        mutable std::vector<GLint> _drawBaseVertices;
+
+        explicit Model(AsyncLoad);
+
+        // The CPU half of loading: reads the mesh cache or imports through Assimp, and prepares every mesh.
+        // Touches no GL state, so it can run on a worker thread.
+        bool importModel();
+        // The GL half, run on the context thread. Stops once deadline passes; returns true when loading has finished.
+        bool continueLoading(std::chrono::steady_clock::time_point deadline);
+        bool loadFromMeshCache(const std::string& cachePath, const MeshCacheKey& key);
+        void processNode(const aiNode* node, const aiScene* scene, int parentNode);
+        // Appends the mesh to _meshes, split into several if it is too large for 16-bit indices.
+        void processMesh(aiMesh* mesh, const aiScene* scene);
         static Material loadMaterial(const aiMaterial* aiMaterial);
         std::vector<Texture> loadMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName);
+        Texture loadTexture(const std::string& texturePath, const std::string& typeName);
+        void startTextureDecodes();
+        // uploads decoded textures in order until deadline, waiting for their decodes only when blocking
+        bool uploadDecodedTextures(std::chrono::steady_clock::time_point deadline, bool blocking);
+        void assignTextureIds();
+        void packTextures();
+        void setupBounds();
+        void logGeometryMemory(const std::string& path) const;
+        static VertexFormat selectMeshVertexFormat(std::span<const Vertex> vertices);
+        void drawInstanceData(const Graphics::Shader& shader) const;
+        void setupDrawBatches();
+        MultiDrawStats drawBatches(const Graphics::Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix,
+                                   const Math::Frustum* frustum) const;
     };
 }
 
@@ -5,6 +5,8 @@
 
 #include <string>
 
+#include "../Graphics/Image.h"
+
 namespace LearnOpenGL::Model
 {
     class Texture
@@ -14,6 +16,10 @@ namespace LearnOpenGL::Model
         std::string type;
         std::string path;
         static unsigned int loadFromFile(const char* texturePath, const std::string& directory);
+
+        // Creates the texture for already decoded pixels, so decoding can happen away from the context thread.
+        // The pixels stream in through the UploadScheduler; the texture is complete once it caught up.
+        static unsigned int upload(Graphics::Image image, const std::string& filename);
     };
 }
 
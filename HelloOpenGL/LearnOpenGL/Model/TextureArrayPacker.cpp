@@ -0,0 +1,238 @@
+﻿#include "TextureArrayPacker.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <glad/glad.h>
+
+#include "../Graphics/GLStateCache.h"
+
+namespace LearnOpenGL::Model
+{
+    size_t TextureArrayPacker::add(const unsigned int textureId, const bool allowAtlas)
+    {
+        GLint width = 0;
+        GLint height = 0;
+
+        Graphics::GLStateCache::bindTexture(GL_TEXTURE_2D, textureId);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+        const bool atlas = allowAtlas && width <= AtlasMaxTextureSize && height <= AtlasMaxTextureSize;
+        _entries.push_back({ textureId, width, height, atlas });
+
+        return _entries.size() - 1;
+    }
+
+    std::vector<TextureArrayLocation> TextureArrayPacker::pack(std::vector<unsigned int>& arrayTextures)
+    {
+        std::vector<TextureArrayLocation> locations(_entries.size());
+        const size_t firstArray = arrayTextures.size();
+        _stats = {};
+
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+        // a lone small texture gains nothing from an atlas, it goes into a layer of its own instead
+        const auto atlasCount = std::count_if(_entries.begin(), _entries.end(), [](const Entry& entry) { return entry.atlas; });
+        std::map<std::pair<int, int>, std::vector<size_t>> layersBySize;
+        std::vector<size_t> atlasEntries;
+
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            const Entry& entry = _entries[i];
+
+            if (entry.width <= 0 || entry.height <= 0)
+            {
+                std::cerr << "Cannot pack texture " << entry.textureId << ", it has no level 0.\n";
+                continue;
+            }
+
+            if (entry.atlas && atlasCount > 1)
+            {
+                atlasEntries.push_back(i);
+            }
+            else
+            {
+                layersBySize[{ entry.width, entry.height }].push_back(i);
+            }
+        }
+
+        unsigned int framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        Graphics::GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+
+        const auto copyToLayer = [this](const size_t entryIndex, const unsigned int arrayTexture, const int layer, const int x,
+                                        const int y)
+        {
+            const Entry& entry = _entries[entryIndex];
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, entry.textureId, 0);
+
+            if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cerr << "Cannot pack texture " << entry.textureId << ", it cannot be read through a framebuffer.\n";
+                return false;
+            }
+
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+            glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, 0, 0, entry.width, entry.height);
+            _stats.textures++;
+
+            return true;
+        };
+
+        for (const auto& [size, entries] : layersBySize)
+        {
+            const auto [width, height] = size;
+
+            for (size_t first = 0; first < entries.size(); first += static_cast<size_t>(maxLayers))
+            {
+                const auto layers = static_cast<int>(std::min(entries.size() - first, static_cast<size_t>(maxLayers)));
+                const int mipLevels = getMipLevels(width, height);
+                const unsigned int arrayTexture = createArray(width, height, layers, mipLevels);
+                arrayTextures.push_back(arrayTexture);
+
+                for (int layer = 0; layer < layers; layer++)
+                {
+                    const size_t entryIndex = entries[first + layer];
+
+                    if (copyToLayer(entryIndex, arrayTexture, layer, 0, 0))
+                    {
+                        locations[entryIndex] = { arrayTexture, layer };
+                    }
+                }
+
+                _stats.layers += layers;
+                // the mip chain adds about a third on top of the base level
+                _stats.bytes += static_cast<size_t>(width) * height * 4 * layers * 4 / 3;
+            }
+        }
+
+        if (!atlasEntries.empty())
+        {
+            // shelf packing, tallest first so each shelf wastes little height
+            std::ranges::sort(atlasEntries, [this](const size_t a, const size_t b) { return _entries[a].height > _entries[b].height; });
+
+            struct Placement
+            {
+                int layer;
+                int x;
+                int y;
+            };
+
+            std::vector<Placement> placements;
+            placements.reserve(atlasEntries.size());
+
+            int layer = 0;
+            int shelfY = 0;
+            int shelfHeight = 0;
+            int cursorX = 0;
+
+            for (const size_t entryIndex : atlasEntries)
+            {
+                const int cellWidth = _entries[entryIndex].width + AtlasPadding;
+                const int cellHeight = _entries[entryIndex].height + AtlasPadding;
+
+                if (cursorX + cellWidth > AtlasSize)
+                {
+                    shelfY += shelfHeight;
+                    shelfHeight = 0;
+                    cursorX = 0;
+                }
+
+                if (shelfY + cellHeight > AtlasSize)
+                {
+                    layer++;
+                    shelfY = 0;
+                    shelfHeight = 0;
+                    cursorX = 0;
+                }
+
+                placements.push_back({ layer, cursorX + AtlasPadding / 2, shelfY + AtlasPadding / 2 });
+                cursorX += cellWidth;
+                shelfHeight = std::max(shelfHeight, cellHeight);
+            }
+
+            const int layers = std::min(layer + 1, static_cast<int>(maxLayers));
+            // stop before a level's padding shrinks below one texel per side
+            const int mipLevels = getMipLevels(AtlasPadding / 2, AtlasPadding / 2);
+            const unsigned int arrayTexture = createArray(AtlasSize, AtlasSize, layers, mipLevels);
+            arrayTextures.push_back(arrayTexture);
+
+            for (size_t i = 0; i < atlasEntries.size(); i++)
+            {
+                const size_t entryIndex = atlasEntries[i];
+                const Entry& entry = _entries[entryIndex];
+                const Placement& placement = placements[i];
+
+                if (placement.layer >= layers || !copyToLayer(entryIndex, arrayTexture, placement.layer, placement.x, placement.y))
+                {
+                    continue;
+                }
+
+                // inset by half a texel, so bilinear filtering at the edges never reaches into the padding
+                const float atlasSize = AtlasSize;
+                locations[entryIndex] = {
+                    arrayTexture, placement.layer,
+                    glm::vec4(static_cast<float>(entry.width - 1) / atlasSize, static_cast<float>(entry.height - 1) / atlasSize,
+                              (static_cast<float>(placement.x) + 0.5f) / atlasSize, (static_cast<float>(placement.y) + 0.5f) / atlasSize)
+                };
+                _stats.atlasTextures++;
+            }
+
+            _stats.layers += layers;
+            _stats.bytes += static_cast<size_t>(AtlasSize) * AtlasSize * 4 * layers * 4 / 3;
+        }
+
+        Graphics::GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        Graphics::GLStateCache::onFramebufferDeleted(framebuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+
+        for (size_t i = firstArray; i < arrayTextures.size(); i++)
+        {
+            Graphics::GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, arrayTextures[i]);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+
+        Graphics::GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        _stats.arrays = arrayTextures.size() - firstArray;
+
+        return locations;
+    }
+
+    const TextureArrayPackerStats& TextureArrayPacker::getStats() const
+    {
+        return _stats;
+    }
+
+    unsigned int TextureArrayPacker::createArray(const int width, const int height, const int layers, const int mipLevels)
+    {
+        unsigned int arrayTexture;
+        glGenTextures(1, &arrayTexture);
+        Graphics::GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+
+        // model textures are RGB, RGBA or single channel; RGBA8 holds all of them, reading as the originals did
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        return arrayTexture;
+    }
+
+    int TextureArrayPacker::getMipLevels(const int width, const int height)
+    {
+        int levels = 1;
+
+        for (int size = std::max(width, height); size > 1; size /= 2)
+        {
+            levels++;
+        }
+
+        return levels;
+    }
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#ifndef TEXTURE_ARRAY_PACKER_H
+#define TEXTURE_ARRAY_PACKER_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace LearnOpenGL::Model
+{
+    // Where a packed texture ended up: a layer of a GL_TEXTURE_2D_ARRAY, and for atlas entries the rectangle inside it.
+    struct TextureArrayLocation
+    {
+        // 0 when there is no texture
+        unsigned int arrayTexture = 0;
+        int layer = -1;
+        // scale in xy and offset in zw, mapping the texture's coordinates into the layer
+        glm::vec4 rectangle{ 1.0f, 1.0f, 0.0f, 0.0f };
+    };
+
+    struct TextureArrayPackerStats
+    {
+        size_t textures;
+        size_t arrays;
+        size_t layers;
+        size_t atlasTextures;
+        size_t bytes;
+    };
+
+    // Copies separately uploaded 2D textures into GL_TEXTURE_2D_ARRAY layers, so meshes using different textures can be
+    // drawn with one binding. Same-size textures share an array; small ones can instead be rectangle packed into atlas
+    // layers. Copies run on the GPU through a framebuffer, so textures that were uploaded earlier need no CPU pixels.
+    class TextureArrayPacker
+    {
+    public:
+        // Textures up to this size on both sides may go into atlas layers.
+        static constexpr int AtlasMaxTextureSize = 256;
+        static constexpr int AtlasSize = 2048;
+        // space kept around atlas entries, which also caps their mip chain so levels never blend neighbors together
+        static constexpr int AtlasPadding = 8;
+
+        // allowAtlas is only safe for textures sampled with coordinates in [0, 1], since atlas entries cannot repeat.
+        // Returns the index pack() reports the texture's location under.
+        size_t add(unsigned int textureId, bool allowAtlas);
+
+        // Creates the arrays and copies every added texture into them. The caller owns the returned arrays.
+        std::vector<TextureArrayLocation> pack(std::vector<unsigned int>& arrayTextures);
+
+        [[nodiscard]] const TextureArrayPackerStats& getStats() const;
+
+    private:
+        struct Entry
+        {
+            unsigned int textureId;
+            int width;
+            int height;
+            bool atlas;
+        };
+
+        std::vector<Entry> _entries;
+        TextureArrayPackerStats _stats{};
+
+        static unsigned int createArray(int width, int height, int layers, int mipLevels);
+        static int getMipLevels(int width, int height);
+    };
+}
+
+#endif
@@ -12,7 +12,14 @@ namespace LearnOpenGL::Model
         glm::vec3 position;
         glm::vec3 normal;
         glm::vec2 textureCoordinates;
+        // w is the bitangent's sign: bitangent = cross(normal, tangent.xyz) * tangent.w
+        glm::vec4 tangent;
     };
+
+    // after the per-instance attributes at 3-9
+    constexpr unsigned int TangentLocation = 10;
+    // index into a multi-drawn model's draw table, one per draw rather than per vertex
+    constexpr unsigned int DrawIndexLocation = 11;
 }
 
 #endif
@@ -0,0 +1,120 @@
+﻿#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+namespace LearnOpenGL::Model
+{
+    namespace
+    {
+        // half floats keep at least 11 bits of precision below 2, plenty for 4k textures
+        constexpr float MaxCompactTextureCoordinate = 2.0f;
+    }
+
+    VertexFormat selectVertexFormat(const std::span<const Vertex> vertices, const float maxPositionError)
+    {
+        if (vertices.empty())
+        {
+            return VertexFormat::Full;
+        }
+
+        const VertexQuantization quantization = calculateQuantization(vertices);
+
+        // rounding is off by at most half a step
+        const float maxScale = std::max({ quantization.scale.x, quantization.scale.y, quantization.scale.z });
+        if (maxScale * 0.5f > maxPositionError)
+        {
+            return VertexFormat::Full;
+        }
+
+        for (const Vertex& vertex : vertices)
+        {
+            if (std::abs(vertex.textureCoordinates.x) > MaxCompactTextureCoordinate
+                || std::abs(vertex.textureCoordinates.y) > MaxCompactTextureCoordinate)
+            {
+                return VertexFormat::Full;
+            }
+        }
+
+        return VertexFormat::Compact;
+    }
+
+    VertexQuantization calculateQuantization(const std::span<const Vertex> vertices)
+    {
+        if (vertices.empty())
+        {
+            return { glm::vec3(0.0f), glm::vec3(1.0f) };
+        }
+
+        glm::vec3 min = vertices.front().position;
+        glm::vec3 max = vertices.front().position;
+
+        for (const Vertex& vertex : vertices)
+        {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+
+        return { min, (max - min) / 65535.0f };
+    }
+
+    std::vector<CompactVertex> compressVertices(const std::span<const Vertex> vertices, const VertexQuantization& quantization)
+    {
+        std::vector<CompactVertex> result;
+        result.reserve(vertices.size());
+
+        // flat axes have no scale, and every position sits on the offset anyway
+        const glm::vec3 inverseScale{
+            quantization.scale.x > 0.0f ? 1.0f / quantization.scale.x : 0.0f,
+            quantization.scale.y > 0.0f ? 1.0f / quantization.scale.y : 0.0f,
+            quantization.scale.z > 0.0f ? 1.0f / quantization.scale.z : 0.0f
+        };
+
+        for (const Vertex& vertex : vertices)
+        {
+            CompactVertex compact{};
+
+            const glm::vec3 quantized = glm::clamp(glm::round((vertex.position - quantization.offset) * inverseScale),
+                                                   glm::vec3(0.0f), glm::vec3(65535.0f));
+
+            compact.position[0] = static_cast<uint16_t>(quantized.x);
+            compact.position[1] = static_cast<uint16_t>(quantized.y);
+            compact.position[2] = static_cast<uint16_t>(quantized.z);
+
+            compact.normal = glm::packSnorm3x10_1x2(glm::vec4(encodeOctahedral(vertex.normal), 0.0f, 0.0f));
+            compact.tangent = glm::packSnorm3x10_1x2(glm::vec4(encodeOctahedral(glm::vec3(vertex.tangent)), 0.0f,
+                                                               vertex.tangent.w < 0.0f ? -1.0f : 1.0f));
+
+            compact.textureCoordinates[0] = glm::packHalf1x16(vertex.textureCoordinates.x);
+            compact.textureCoordinates[1] = glm::packHalf1x16(vertex.textureCoordinates.y);
+
+            result.push_back(compact);
+        }
+
+        return result;
+    }
+
+    glm::vec2 encodeOctahedral(const glm::vec3& direction)
+    {
+        const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+
+        if (length <= 0.0f)
+        {
+            return glm::vec2(0.0f);
+        }
+
+        // project onto the octahedron, then fold the lower half over the upper one
+        const glm::vec3 projected = direction / length;
+
+        if (projected.z >= 0.0f)
+        {
+            return { projected.x, projected.y };
+        }
+
+        return {
+            (1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f)
+        };
+    }
+}
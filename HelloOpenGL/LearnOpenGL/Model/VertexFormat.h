@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+
+namespace LearnOpenGL::Model
+{
+    // Layout a mesh's vertex buffer is uploaded in. The shaders decode either, switched by the compactVertices uniform.
+    enum class VertexFormat
+    {
+        // Vertex as is, 48 bytes
+        Full,
+        // CompactVertex, 20 bytes
+        Compact
+    };
+
+    // Position as 16-bit unorm within the mesh bounds, normal and tangent octahedral-encoded into 10:10:10:2 snorm
+    // (the tangent's w holds the bitangent sign), texture coordinates as half floats.
+    struct CompactVertex
+    {
+        uint16_t position[4];
+        uint32_t normal;
+        uint32_t tangent;
+        uint16_t textureCoordinates[2];
+    };
+
+    static_assert(sizeof(CompactVertex) == 20);
+
+    // Maps unorm positions back into model space: position = offset + quantized * scale.
+    struct VertexQuantization
+    {
+        glm::vec3 offset;
+        glm::vec3 scale;
+    };
+
+    // Compact unless the quantized positions would be off by more than maxPositionError, or the texture coordinates
+    // reach far enough past [0, 1] for half floats to lose texel precision.
+    VertexFormat selectVertexFormat(std::span<const Vertex> vertices, float maxPositionError = 0.001f);
+
+    VertexQuantization calculateQuantization(std::span<const Vertex> vertices);
+    std::vector<CompactVertex> compressVertices(std::span<const Vertex> vertices, const VertexQuantization& quantization);
+
+    glm::vec2 encodeOctahedral(const glm::vec3& direction);
+}
+
+#endif
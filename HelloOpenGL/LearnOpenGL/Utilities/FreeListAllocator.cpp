@@ -0,0 +1,133 @@
+﻿#include "FreeListAllocator.h"
+
+#include <algorithm>
+
+namespace LearnOpenGL::Utilities
+{
+    FreeListAllocator::FreeListAllocator(const size_t capacity)
+        : _capacity(capacity)
+    {
+        if (capacity > 0)
+        {
+            _freeRanges.push_back({ 0, capacity });
+        }
+    }
+
+    std::optional<size_t> FreeListAllocator::allocate(const size_t size, const size_t alignment)
+    {
+        if (size == 0)
+        {
+            return std::nullopt;
+        }
+
+        for (auto range = _freeRanges.begin(); range != _freeRanges.end(); ++range)
+        {
+            const size_t alignedOffset = (range->offset + alignment - 1) / alignment * alignment;
+            const size_t padding = alignedOffset - range->offset;
+
+            if (range->size < size + padding)
+            {
+                continue;
+            }
+
+            const size_t remainingOffset = alignedOffset + size;
+            const size_t remainingSize = range->offset + range->size - remainingOffset;
+
+            // alignment padding at the front stays free as its own range
+            if (padding > 0)
+            {
+                range->size = padding;
+
+                if (remainingSize > 0)
+                {
+                    _freeRanges.insert(range + 1, { remainingOffset, remainingSize });
+                }
+            }
+            else if (remainingSize > 0)
+            {
+                *range = { remainingOffset, remainingSize };
+            }
+            else
+            {
+                _freeRanges.erase(range);
+            }
+
+            _used += size;
+            return alignedOffset;
+        }
+
+        return std::nullopt;
+    }
+
+    void FreeListAllocator::free(const size_t offset, const size_t size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        auto next = std::lower_bound(_freeRanges.begin(), _freeRanges.end(), offset, [](const Range& range, const size_t value)
+        {
+            return range.offset < value;
+        });
+
+        auto inserted = _freeRanges.insert(next, { offset, size });
+
+        if (inserted + 1 != _freeRanges.end() && inserted->offset + inserted->size == (inserted + 1)->offset)
+        {
+            inserted->size += (inserted + 1)->size;
+            _freeRanges.erase(inserted + 1);
+        }
+
+        if (inserted != _freeRanges.begin() && (inserted - 1)->offset + (inserted - 1)->size == inserted->offset)
+        {
+            (inserted - 1)->size += inserted->size;
+            _freeRanges.erase(inserted);
+        }
+
+        _used -= size;
+    }
+
+    void FreeListAllocator::grow(const size_t newCapacity)
+    {
+        if (newCapacity <= _capacity)
+        {
+            return;
+        }
+
+        const size_t added = newCapacity - _capacity;
+
+        if (!_freeRanges.empty() && _freeRanges.back().offset + _freeRanges.back().size == _capacity)
+        {
+            _freeRanges.back().size += added;
+        }
+        else
+        {
+            _freeRanges.push_back({ _capacity, added });
+        }
+
+        _capacity = newCapacity;
+    }
+
+    size_t FreeListAllocator::getCapacity() const
+    {
+        return _capacity;
+    }
+
+    size_t FreeListAllocator::getUsed() const
+    {
+        return _used;
+    }
+
+    size_t FreeListAllocator::getLargestFreeRange() const
+    {
+        size_t largest = 0;
+
+        for (const Range& range : _freeRanges)
+        {
+            largest = std::max(largest, range.size);
+        }
+
+        return largest;
+    }
+}
@@ -0,0 +1,43 @@
+﻿#pragma once
+#ifndef FREE_LIST_ALLOCATOR_H
+#define FREE_LIST_ALLOCATOR_H
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace LearnOpenGL::Utilities
+{
+    // Hands out ranges of an abstract address space (offsets into a GPU buffer, say) and takes them back.
+    // First fit over a free list kept sorted by offset; freed ranges merge with their neighbours.
+    class FreeListAllocator
+    {
+    public:
+        explicit FreeListAllocator(size_t capacity = 0);
+
+        // Offset of a free range of size units aligned to alignment, or nothing if no free range is big enough.
+        std::optional<size_t> allocate(size_t size, size_t alignment = 1);
+        void free(size_t offset, size_t size);
+
+        // Appends free space at the end; capacity only ever grows.
+        void grow(size_t newCapacity);
+
+        [[nodiscard]] size_t getCapacity() const;
+        [[nodiscard]] size_t getUsed() const;
+        // largest allocation that would currently succeed without alignment
+        [[nodiscard]] size_t getLargestFreeRange() const;
+
+    private:
+        struct Range
+        {
+            size_t offset;
+            size_t size;
+        };
+
+        std::vector<Range> _freeRanges;
+        size_t _capacity;
+        size_t _used = 0;
+    };
+}
+
+#endif // FREE_LIST_ALLOCATOR_H
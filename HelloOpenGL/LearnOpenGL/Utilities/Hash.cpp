@@ -0,0 +1,39 @@
+﻿#include "Hash.h"
+
+#include "MappedFile.h"
+
+namespace LearnOpenGL::Utilities
+{
+    constexpr uint64_t HashPrime = 1099511628211ull;
+
+    uint64_t hashBytes(const void* data, const size_t size, const uint64_t seed)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= HashPrime;
+        }
+
+        return hash;
+    }
+
+    uint64_t hashString(const std::string& string, const uint64_t seed)
+    {
+        return hashBytes(string.data(), string.size(), seed);
+    }
+
+    std::optional<uint64_t> hashFile(const std::string& fileLocation, const uint64_t seed)
+    {
+        const MappedFile file{ fileLocation };
+
+        if (!file.isOpen())
+        {
+            return std::nullopt;
+        }
+
+        return hashBytes(file.getData(), file.getSize(), seed);
+    }
+}
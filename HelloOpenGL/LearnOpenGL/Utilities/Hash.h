@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace LearnOpenGL::Utilities
+{
+    // 64-bit FNV-1a. Not cryptographic, only used to detect stale cache entries.
+    constexpr uint64_t HashSeed = 14695981039346656037ull;
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = HashSeed);
+    uint64_t hashString(const std::string& string, uint64_t seed = HashSeed);
+    std::optional<uint64_t> hashFile(const std::string& fileLocation, uint64_t seed = HashSeed);
+}
+
+#endif // HASH_H
@@ -0,0 +1,169 @@
+﻿#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace LearnOpenGL::Utilities
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& fileLocation)
+    {
+        HANDLE file = CreateFileA(fileLocation.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        _fileHandle = file;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return;
+        }
+
+        _mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (!_mappingHandle)
+        {
+            close();
+            return;
+        }
+
+        _data = static_cast<const unsigned char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        _size = _data ? static_cast<size_t>(fileSize.QuadPart) : 0;
+    }
+
+    void MappedFile::close()
+    {
+        if (_data)
+        {
+            UnmapViewOfFile(_data);
+        }
+
+        if (_mappingHandle)
+        {
+            CloseHandle(_mappingHandle);
+        }
+
+        if (_fileHandle)
+        {
+            CloseHandle(_fileHandle);
+        }
+
+        _data = nullptr;
+        _size = 0;
+        _mappingHandle = nullptr;
+        _fileHandle = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string& fileLocation)
+    {
+        _fileDescriptor = open(fileLocation.c_str(), O_RDONLY);
+
+        if (_fileDescriptor < 0)
+        {
+            return;
+        }
+
+        struct stat fileStatus{};
+        if (fstat(_fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+        {
+            close();
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+
+        if (data == MAP_FAILED)
+        {
+            close();
+            return;
+        }
+
+        _data = static_cast<const unsigned char*>(data);
+        _size = static_cast<size_t>(fileStatus.st_size);
+    }
+
+    void MappedFile::close()
+    {
+        if (_data)
+        {
+            munmap(const_cast<unsigned char*>(_data), _size);
+        }
+
+        if (_fileDescriptor >= 0)
+        {
+            ::close(_fileDescriptor);
+        }
+
+        _data = nullptr;
+        _size = 0;
+        _fileDescriptor = -1;
+    }
+#endif
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : _data(std::exchange(other._data, nullptr)),
+          _size(std::exchange(other._size, 0)),
+#ifdef _WIN32
+          _fileHandle(std::exchange(other._fileHandle, nullptr)),
+          _mappingHandle(std::exchange(other._mappingHandle, nullptr))
+#else
+          _fileDescriptor(std::exchange(other._fileDescriptor, -1))
+#endif
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+#ifdef _WIN32
+            _fileHandle = std::exchange(other._fileHandle, nullptr);
+            _mappingHandle = std::exchange(other._mappingHandle, nullptr);
+#else
+            _fileDescriptor = std::exchange(other._fileDescriptor, -1);
+#endif
+        }
+
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::isOpen() const
+    {
+        return _data != nullptr;
+    }
+
+    const unsigned char* MappedFile::getData() const
+    {
+        return _data;
+    }
+
+    size_t MappedFile::getSize() const
+    {
+        return _size;
+    }
+}
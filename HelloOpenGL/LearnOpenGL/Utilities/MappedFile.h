@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace LearnOpenGL::Utilities
+{
+    // Read-only view of a whole file mapped into memory. The view is released when the object is destroyed.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string& fileLocation);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        [[nodiscard]] bool isOpen() const;
+        [[nodiscard]] const unsigned char* getData() const;
+        [[nodiscard]] size_t getSize() const;
+
+    private:
+        const unsigned char* _data{};
+        size_t _size{};
+
+#ifdef _WIN32
+        void* _fileHandle{};
+        void* _mappingHandle{};
+#else
+        int _fileDescriptor = -1;
+#endif
+
+        void close();
+    };
+}
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,83 @@
+﻿#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace LearnOpenGL::Utilities
+{
+    ThreadPool::ThreadPool(const unsigned int threadCount)
+    {
+        _workers.reserve(threadCount);
+
+        for (unsigned int i = 0; i < std::max(threadCount, 1u); i++)
+        {
+            _workers.emplace_back(&ThreadPool::runWorker, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(_tasksMutex);
+            _stopping = true;
+        }
+
+        _tasksAvailable.notify_all();
+
+        for (std::thread& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::getThreadCount() const
+    {
+        return _workers.size();
+    }
+
+    ThreadPool& ThreadPool::getShared()
+    {
+        static ThreadPool sharedPool;
+        return sharedPool;
+    }
+
+    unsigned int ThreadPool::getDefaultThreadCount()
+    {
+        // leave a core for the thread owning the GL context
+        const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    void ThreadPool::enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(_tasksMutex);
+            _tasks.push_back(std::move(task));
+        }
+
+        _tasksAvailable.notify_one();
+    }
+
+    void ThreadPool::runWorker()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock lock(_tasksMutex);
+                _tasksAvailable.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+
+                // remaining tasks are still drained on shutdown, so no future is left without a value
+                if (_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+}
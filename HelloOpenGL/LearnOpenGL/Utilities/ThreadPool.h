@@ -0,0 +1,60 @@
+﻿#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace LearnOpenGL::Utilities
+{
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned int threadCount = getDefaultThreadCount());
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ThreadPool& operator=(ThreadPool&&) = delete;
+
+        ~ThreadPool();
+
+        [[nodiscard]] size_t getThreadCount() const;
+
+        template <typename Task>
+        std::future<std::invoke_result_t<Task>> submit(Task&& task)
+        {
+            using Result = std::invoke_result_t<Task>;
+
+            auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+            std::future<Result> result = packagedTask->get_future();
+
+            enqueue([packagedTask] { (*packagedTask)(); });
+
+            return result;
+        }
+
+        // Pool shared by everything that only needs background work done, created on first use.
+        static ThreadPool& getShared();
+        static unsigned int getDefaultThreadCount();
+
+    private:
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _tasks;
+        std::mutex _tasksMutex;
+        std::condition_variable _tasksAvailable;
+        bool _stopping = false;
+
+        void enqueue(std::function<void()> task);
+        void runWorker();
+    };
+}
+
+#endif // THREAD_POOL_H
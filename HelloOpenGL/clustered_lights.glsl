@@ -0,0 +1,39 @@
+// point lights sorted into view-space clusters by LightClusters; needs frame_uniforms.glsl and the PointLight struct
+layout (std140) uniform ClusterUniforms
+{
+    uvec4 clusterGridSize;
+    // clusters per pixel in x and y
+    vec2 clusterTileScale;
+    float clusterDepthScale;
+    float clusterDepthBias;
+};
+
+// four texels per light, in PointLight's order with the radius in the last one's alpha
+uniform samplerBuffer clusterLights;
+// offset into clusterLightIndices and light count of every cluster
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer clusterLightIndices;
+
+uvec2 getLightCluster(vec3 worldPosition)
+{
+    float viewDepth = -(view * vec4(worldPosition, 1.0f)).z;
+    float slice = max(log(viewDepth) * clusterDepthScale + clusterDepthBias, 0.0f);
+    uvec3 cluster = min(uvec3(uvec2(gl_FragCoord.xy * clusterTileScale), uint(slice)), clusterGridSize.xyz - 1u);
+
+    return texelFetch(clusterRanges, int(cluster.x + clusterGridSize.x * (cluster.y + clusterGridSize.y * cluster.z))).xy;
+}
+
+PointLight fetchClusterLight(uint lightIndex)
+{
+    int texel = int(lightIndex) * 4;
+    vec4 positionRadius = texelFetch(clusterLights, texel + 3);
+
+    PointLight pointLight;
+    pointLight.ambient = texelFetch(clusterLights, texel).rgb;
+    pointLight.diffuse = texelFetch(clusterLights, texel + 1).rgb;
+    pointLight.specular = texelFetch(clusterLights, texel + 2).rgb;
+    pointLight.position = positionRadius.xyz;
+    pointLight.radius = positionRadius.w;
+
+    return pointLight;
+}
@@ -0,0 +1,16 @@
+// set for meshes uploaded as CompactVertex: positions are 0-1 within the mesh bounds, normals octahedral in xy
+uniform bool compactVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+
+    if (direction.z < 0.0f)
+    {
+        direction.xy = (1.0f - abs(direction.yx)) * vec2(direction.x >= 0.0f ? 1.0f : -1.0f, direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return normalize(direction);
+}
@@ -0,0 +1,47 @@
+#version 330 core
+
+#include "shader_features.glsl"
+
+in vec2 screenCoordinates;
+
+out vec4 fragmentColor;
+
+#include "phong_lighting.glsl"
+
+// written by gbuffer.frag
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gSpecular;
+uniform sampler2D gEmission;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+
+    // nothing was drawn here, so whatever the target already holds stays
+    if (depth == 1.0f)
+    {
+        discard;
+    }
+
+    vec4 position = inverseViewProjection * vec4(vec3(screenCoordinates, depth) * 2.0f - 1.0f, 1.0f);
+    vec3 fragmentPosition = position.xyz / position.w;
+
+    // the G-buffer holds the sums of samples and material colors, so the colors add nothing here
+    vec4 specularShininess = texelFetch(gSpecular, texel, 0);
+    diffuseSample = texelFetch(gAlbedo, texel, 0).rgb;
+    diffuseColor = vec3(0.0f);
+    specularSample = specularShininess.rgb;
+    specularColor = vec3(0.0f);
+    shininess = specularShininess.a * MAX_SHININESS;
+    emissionColor = texelFetch(gEmission, texel, 0).rgb;
+
+    vec3 normalizedNormal = normalize(texelFetch(gNormal, texel, 0).xyz);
+    vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+
+    fragmentColor = vec4(calculateLighting(normalizedNormal, fragmentPosition, viewDirection) + emissionColor, 1.0f);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+out vec2 screenCoordinates;
+
+void main()
+{
+    // one triangle covering the whole screen, generated without any vertex data
+    vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+
+    screenCoordinates = position;
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
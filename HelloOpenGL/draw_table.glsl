@@ -0,0 +1,4 @@
+// set while a model is multi-drawn: per-mesh values come from its draw table, eight texels per draw
+#define DRAW_RECORD_TEXELS 8
+uniform bool useDrawTable;
+uniform samplerBuffer drawTable;
@@ -0,0 +1,6 @@
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+};
@@ -0,0 +1,27 @@
+#version 330 core
+
+#include "shader_features.glsl"
+
+in vec3 fragmentPosition;
+in vec3 normal;
+in vec2 textureCoordinates;
+flat in int drawIndex;
+
+// in DeferredRenderer::GBufferTarget order
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gSpecular;
+layout (location = 3) out vec4 gEmission;
+
+#include "material.glsl"
+
+void main()
+{
+    loadMaterial();
+
+    // lighting only ever uses the clamped sums, so that is all that gets stored
+    gAlbedo = vec4(clamp(diffuseSample + diffuseColor, 0.0f, 1.0f), 1.0f);
+    gNormal = vec4(normalize(normal), 0.0f);
+    gSpecular = vec4(clamp(specularSample + specularColor, 0.0f, 1.0f), clamp(shininess / MAX_SHININESS, 0.0f, 1.0f));
+    gEmission = vec4(emissionColor, 1.0f);
+}
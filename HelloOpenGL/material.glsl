@@ -0,0 +1,100 @@
+// the material uniforms and loadMaterial(), which fills in the surface; needs the textureCoordinates and drawIndex inputs
+#include "shader_features.glsl"
+#include "surface.glsl"
+
+struct Material
+{
+    sampler2D diffuse1;
+    sampler2D specular1;
+    // used instead of the above once the model's textures are packed into arrays; a layer of -1 means no texture
+    sampler2DArray diffuseArray;
+    sampler2DArray specularArray;
+    int diffuseLayer;
+    int specularLayer;
+    // scale in xy and offset in zw, for textures packed into an atlas
+    vec4 diffuseRectangle;
+    vec4 specularRectangle;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    vec3 emissionColor;
+    float shininess;
+};
+
+uniform Material material;
+uniform bool useTextureArrays;
+
+#ifdef DRAW_TABLE
+#include "draw_table.glsl"
+#endif
+
+vec3 sampleLayer(sampler2DArray textureArray, int layer, vec4 rectangle);
+
+void loadMaterial()
+{
+    diffuseColor = material.diffuseColor;
+    specularColor = material.specularColor;
+    emissionColor = material.emissionColor;
+    shininess = material.shininess;
+
+    bool textureArrays = useTextureArrays;
+    int diffuseLayer = material.diffuseLayer;
+    int specularLayer = material.specularLayer;
+    vec4 diffuseRectangle = material.diffuseRectangle;
+    vec4 specularRectangle = material.specularRectangle;
+
+#ifdef DRAW_TABLE
+    if (useDrawTable)
+    {
+        vec4 layers = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 5);
+        textureArrays = layers.z != 0.0f;
+        diffuseLayer = int(layers.x);
+        specularLayer = int(layers.y);
+        diffuseRectangle = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 6);
+        specularRectangle = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 7);
+
+        vec4 diffuseTexel = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 2);
+        diffuseColor = diffuseTexel.rgb;
+        specularColor = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 3).rgb;
+        emissionColor = texelFetch(drawTable, drawIndex * DRAW_RECORD_TEXELS + 4).rgb;
+
+        // negative for textured meshes, which keep the shininess set by the application
+        if (diffuseTexel.a >= 0.0f)
+        {
+            shininess = diffuseTexel.a;
+        }
+    }
+#endif
+
+    // untextured variants skip sampling entirely; unbound textures would read black anyway
+    diffuseSample = vec3(0.0f);
+    specularSample = vec3(0.0f);
+
+#if defined(TEXTURE_ARRAYS) && defined(TEXTURES_2D)
+    if (textureArrays)
+    {
+        diffuseSample = sampleLayer(material.diffuseArray, diffuseLayer, diffuseRectangle);
+        specularSample = sampleLayer(material.specularArray, specularLayer, specularRectangle);
+    }
+    else
+    {
+        diffuseSample = texture(material.diffuse1, textureCoordinates).rgb;
+        specularSample = texture(material.specular1, textureCoordinates).rgb;
+    }
+#elif defined(TEXTURE_ARRAYS)
+    diffuseSample = sampleLayer(material.diffuseArray, diffuseLayer, diffuseRectangle);
+    specularSample = sampleLayer(material.specularArray, specularLayer, specularRectangle);
+#elif defined(TEXTURES_2D)
+    diffuseSample = texture(material.diffuse1, textureCoordinates).rgb;
+    specularSample = texture(material.specular1, textureCoordinates).rgb;
+#endif
+}
+
+vec3 sampleLayer(sampler2DArray textureArray, int layer, vec4 rectangle)
+{
+    if (layer < 0)
+    {
+        return vec3(0.0f);
+    }
+
+    return texture(textureArray, vec3(textureCoordinates * rectangle.xy + rectangle.zw, float(layer))).rgb;
+}
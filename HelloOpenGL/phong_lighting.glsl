@@ -0,0 +1,138 @@
+// lighting of the surface by the directional light, the spotlight and the point lights, for forward and deferred shading
+#include "shader_features.glsl"
+#include "frame_uniforms.glsl"
+#include "surface.glsl"
+
+struct DirectionalLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 direction;
+};
+
+struct SpotLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    vec3 position;
+    vec3 direction;
+    float cutoff;
+    float outerCutoff;
+};
+
+struct PointLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 position;
+    // lighting fades out to nothing at this distance
+    float radius;
+};
+
+layout (std140) uniform LightUniforms
+{
+    DirectionalLight directionalLight;
+    SpotLight spotLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    int pointLightCount;
+};
+
+#ifdef CLUSTERED_LIGHTS
+#include "clustered_lights.glsl"
+#endif
+
+vec3 calculateDirectionalLight(DirectionalLight directionalLight, vec3 normalizedNormal, vec3 viewDirection);
+vec3 calculateSpotLight(SpotLight spotLight, vec3 normal, vec3 fragmentPosition, vec3 viewDirection);
+vec3 calculatePointLight(PointLight pointLight, vec3 normalizedNormal, vec3 fragmentPosition, vec3 viewDirection);
+
+vec3 calculateLighting(vec3 normalizedNormal, vec3 fragmentPosition, vec3 viewDirection)
+{
+    vec3 colorOutput = vec3(0.0f);
+
+    colorOutput += clamp(calculateDirectionalLight(directionalLight, normalizedNormal, viewDirection), 0.0f, 1.0f);
+#ifdef SPOT_LIGHT
+    colorOutput += clamp(calculateSpotLight(spotLight, normalizedNormal, fragmentPosition, viewDirection), 0.0f, 1.0f);
+#endif
+#ifdef CLUSTERED_LIGHTS
+    // only the lights reaching this fragment's cluster, however many there are in the scene
+    uvec2 lightRange = getLightCluster(fragmentPosition);
+
+    for (uint i = 0u; i < lightRange.y; i++)
+    {
+        PointLight pointLight = fetchClusterLight(texelFetch(clusterLightIndices, int(lightRange.x + i)).r);
+        colorOutput += clamp(calculatePointLight(pointLight, normalizedNormal, fragmentPosition, viewDirection), 0.0f, 1.0f);
+    }
+#else
+    // a constant bound lets variants unroll the loop
+    for (int i = 0; i < POINT_LIGHTS; i++)
+    {
+        if (i >= pointLightCount)
+        {
+            break;
+        }
+
+        colorOutput += clamp(calculatePointLight(pointLights[i], normalizedNormal, fragmentPosition, viewDirection), 0.0f, 1.0f);
+    }
+#endif
+
+    return colorOutput;
+}
+
+vec3 calculateDirectionalLight(DirectionalLight directionalLight, vec3 normalizedNormal, vec3 viewDirection)
+{
+    vec3 lightDirection = normalize(-directionalLight.direction);
+    float diffuseImpact = max(dot(normalizedNormal, lightDirection), 0.0f);
+
+    vec3 reflectDirection = reflect(-lightDirection, normalizedNormal);
+    float specularImpact = pow(max(dot(viewDirection, reflectDirection), 0.0f), shininess);
+
+    vec3 ambient = directionalLight.ambient * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 diffuse = diffuseImpact * directionalLight.diffuse * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 specular = specularImpact * directionalLight.specular * clamp(specularSample + specularColor, 0.0f, 1.0f);
+
+    return ambient + diffuse + specular;
+}
+
+vec3 calculateSpotLight(SpotLight spotLight, vec3 normalizedNormal, vec3 fragmentPosition, vec3 viewDirection)
+{
+    vec3 lightDirection = normalize(spotLight.position - fragmentPosition);
+    float diffuseImpact = max(dot(lightDirection, normalizedNormal), 0.0f);
+
+    vec3 reflectDirection = reflect(-lightDirection, normalizedNormal);
+    vec3 halfwayDirection = normalize(lightDirection + viewDirection);
+    float specularImpact = pow(max(dot(normalizedNormal, halfwayDirection), 0.0f), shininess);
+
+    float theta = dot(lightDirection, normalize(-spotLight.direction));
+    float epsilon = spotLight.cutoff - spotLight.outerCutoff;
+    float intensity = clamp((theta - spotLight.outerCutoff) / epsilon, 0.0f, 1.0f);
+
+    vec3 ambient = spotLight.ambient * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 diffuse = (intensity * diffuseImpact) * spotLight.diffuse * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 specular = (intensity * specularImpact) * spotLight.specular * clamp(specularSample + specularColor, 0.0f, 1.0f);
+
+    return ambient + diffuse + specular;
+}
+
+vec3 calculatePointLight(PointLight pointLight, vec3 normalizedNormal, vec3 fragmentPosition, vec3 viewDirection)
+{
+    vec3 lightDirection = normalize(pointLight.position - fragmentPosition);
+    float diffuseImpact = max(dot(lightDirection, normalizedNormal), 0.0f);
+
+    vec3 reflectDirection = reflect(-lightDirection, normalizedNormal);
+    float specularImpact = pow(max(dot(viewDirection, reflectDirection), 0.0f), shininess);
+
+    // windowed so the light reaches exactly zero at its radius, which is what lets clustering skip it beyond that
+    float lightDistance = length(pointLight.position - fragmentPosition);
+    float falloff = clamp(1.0f - pow(lightDistance / pointLight.radius, 4.0f), 0.0f, 1.0f);
+    float attenuation = falloff * falloff / max(lightDistance, 0.01f);
+
+    vec3 ambient = attenuation * pointLight.ambient * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 diffuse = (attenuation * diffuseImpact) * pointLight.diffuse * clamp(diffuseSample + diffuseColor, 0.0f, 1.0f);
+    vec3 specular = (attenuation * specularImpact) * pointLight.specular * clamp(specularSample + specularColor, 0.0f, 1.0f);
+
+    return ambient + diffuse + specular;
+}
@@ -0,0 +1,15 @@
+// variants get their features injected as defines; a program built without any handles every case at runtime
+#ifndef SHADER_VARIANT
+#define TEXTURES_2D
+#define TEXTURE_ARRAYS
+#define DRAW_TABLE
+#define SPOT_LIGHT
+#define CLUSTERED_LIGHTS
+#endif
+
+// size of the point light array in LightUniforms, which has to match the application's struct
+#define MAX_POINT_LIGHTS 16
+
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS MAX_POINT_LIGHTS
+#endif
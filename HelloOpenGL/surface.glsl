@@ -0,0 +1,10 @@
+// the surface being lit, filled in by loadMaterial() or read back from the G-buffer
+vec3 diffuseColor;
+vec3 specularColor;
+vec3 emissionColor;
+float shininess;
+vec3 diffuseSample;
+vec3 specularSample;
+
+// the G-buffer stores shininess divided by this
+#define MAX_SHININESS 256.0f
@@ -1,22 +1,52 @@
 #version 330 core
 
+#include "shader_features.glsl"
+
 layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec3 inNormal;
+layout (location = 1) in vec4 inNormal;
 layout (location = 2) in vec2 inTextureCoordinates;
+layout (location = 11) in int inDrawIndex;
 
 out vec3 fragmentPosition;
 out vec3 normal;
 out vec2 textureCoordinates;
+flat out int drawIndex;
+
+#include "frame_uniforms.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// transpose(inverse(mat3(model))), computed once per draw on the CPU
+uniform mat3 normalMatrix;
+
+#include "compact_vertices.glsl"
+
+#ifdef DRAW_TABLE
+#include "draw_table.glsl"
+#endif
 
 void main()
 {
-    fragmentPosition = vec3(model * vec4(inPosition, 1.0f));
-    normal = mat3(transpose(inverse(model))) * inNormal;
+    bool compact = compactVertices;
+    vec3 offset = positionOffset;
+    vec3 scale = positionScale;
+
+#ifdef DRAW_TABLE
+    if (useDrawTable)
+    {
+        vec4 offsetTexel = texelFetch(drawTable, inDrawIndex * DRAW_RECORD_TEXELS);
+        compact = offsetTexel.w != 0.0f;
+        offset = offsetTexel.xyz;
+        scale = texelFetch(drawTable, inDrawIndex * DRAW_RECORD_TEXELS + 1).xyz;
+    }
+#endif
+
+    vec3 position = compact ? offset + inPosition * scale : inPosition;
+    vec3 vertexNormal = compact ? decodeOctahedral(inNormal.xy) : inNormal.xyz;
+
+    fragmentPosition = vec3(model * vec4(position, 1.0f));
+    normal = normalMatrix * vertexNormal;
     textureCoordinates = inTextureCoordinates;
+    drawIndex = inDrawIndex;
 
     gl_Position = projection * view * vec4(fragmentPosition, 1.0f);
 }
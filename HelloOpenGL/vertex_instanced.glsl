@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec4 inNormal;
+layout (location = 2) in vec2 inTextureCoordinates;
+layout (location = 3) in mat4 inModel;
+layout (location = 7) in mat3 inNormalMatrix;
+
+out vec3 fragmentPosition;
+out vec3 normal;
+out vec2 textureCoordinates;
+// instanced draws never read the draw table
+flat out int drawIndex;
+
+#include "frame_uniforms.glsl"
+#include "compact_vertices.glsl"
+
+void main()
+{
+    vec3 position = compactVertices ? positionOffset + inPosition * positionScale : inPosition;
+    vec3 vertexNormal = compactVertices ? decodeOctahedral(inNormal.xy) : inNormal.xyz;
+
+    fragmentPosition = vec3(inModel * vec4(position, 1.0f));
+    normal = inNormalMatrix * vertexNormal;
+    textureCoordinates = inTextureCoordinates;
+    drawIndex = 0;
+
+    gl_Position = projection * view * vec4(fragmentPosition, 1.0f);
+}